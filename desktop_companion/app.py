@@ -5,48 +5,282 @@ from __future__ import annotations
 
 import argparse
 import json
+import math
+import random
+import socket
+import struct
 import sys
 import time
-from typing import Any
+from typing import Any, Iterable, Iterator
 
 import requests
 
+# Firmware Emotion enum order; the UDP channel sends the index.
+EMOTIONS = ["neutral", "happy", "sad", "sleepy", "angry", "surprised", "thinking", "love"]
+
 
 class CompanionClient:
     def __init__(self, host: str, timeout: float = 3.0) -> None:
         self.base = f"http://{host}".rstrip("/")
         self.timeout = timeout
 
-    def _post(self, path: str, payload: dict[str, Any]) -> dict[str, Any]:
-        resp = requests.post(f"{self.base}{path}", json=payload, timeout=self.timeout)
+    def _post(self, path: str, payload: dict[str, Any], method: str = "POST") -> dict[str, Any]:
+        resp = requests.request(method, f"{self.base}{path}", json=payload, timeout=self.timeout)
         resp.raise_for_status()
         if not resp.text:
             return {"ok": True}
         return resp.json()
 
-    def _get(self, path: str) -> dict[str, Any]:
-        resp = requests.get(f"{self.base}{path}", timeout=self.timeout)
+    def _get(self, path: str, timeout: float | None = None) -> dict[str, Any]:
+        resp = requests.get(f"{self.base}{path}", timeout=timeout or self.timeout)
         resp.raise_for_status()
         return resp.json()
 
     def status(self) -> dict[str, Any]:
         return self._get("/status")
 
+    def stats(self) -> dict[str, Any]:
+        return self._get("/debug/stats")
+
+    def status_since(self, version: int) -> dict[str, Any]:
+        """Only the state groups changed after `version` (see "changed")."""
+        return self._get(f"/status?since={version}")
+
     def emotion(self, emotion: str) -> dict[str, Any]:
         return self._post("/emotion", {"emotion": emotion})
 
     def speak(self, text: str) -> dict[str, Any]:
         return self._post("/speak", {"text": text})
 
+    def notes(self, offset: int = 0, limit: int = 20) -> dict[str, Any]:
+        """Newest first; page with offset (limit is capped at 50)."""
+        return self._get(f"/notes?offset={offset}&limit={limit}")
+
     def add_note(self, note: str) -> dict[str, Any]:
         return self._post("/notes", {"note": note})
 
     def add_reminder(self, minutes: int, message: str) -> dict[str, Any]:
         return self._post("/reminders", {"minutes": minutes, "message": message})
 
+    def add_reminder_at(self, at: str, message: str) -> dict[str, Any]:
+        """`at` is device-local "HH:MM" (next occurrence) or "YYYY-MM-DDTHH:MM"."""
+        return self._post("/reminders", {"at": at, "message": message})
+
+    def add_recurring_reminder(self, cron: str, message: str) -> dict[str, Any]:
+        """`cron` is "minute hour * * day-of-week", e.g. "30 9 * * 1-5"."""
+        return self._post("/reminders", {"cron": cron, "message": message})
+
+    def reminders(self) -> dict[str, Any]:
+        return self._get("/reminders")
+
+    def cancel_reminder(self, reminder_id: int) -> dict[str, Any]:
+        return self._post("/reminders", {"id": reminder_id}, method="DELETE")
+
+    def edit_reminder(self, reminder_id: int, minutes: int | None = None, message: str | None = None,
+                      at: str | None = None, cron: str | None = None) -> dict[str, Any]:
+        payload: dict[str, Any] = {"id": reminder_id}
+        if minutes is not None:
+            payload["minutes"] = minutes
+        if at is not None:
+            payload["at"] = at
+        if cron is not None:
+            payload["cron"] = cron
+        if message is not None:
+            payload["message"] = message
+        return self._post("/reminders", payload, method="PATCH")
+
     def clear(self) -> dict[str, Any]:
         return self._post("/clear", {})
 
+    def json_bench(self) -> dict[str, Any]:
+        return self._get("/debug/json-bench", timeout=max(self.timeout, 15.0))
+
+    def batch(self) -> "Batch":
+        return Batch(self)
+
+    def send_batch(self, ops: list[dict[str, Any]]) -> dict[str, Any]:
+        resp = requests.post(f"{self.base}/batch", json={"ops": ops}, timeout=self.timeout)
+        # A rejected batch still carries the failing op's index and reason.
+        if resp.status_code in (400, 507) and resp.headers.get("Content-Type", "").startswith("application/json"):
+            return resp.json()
+        resp.raise_for_status()
+        return resp.json()
+
+    def events(self) -> Iterator[tuple[str, dict[str, Any]]]:
+        """Yield (event, data) pairs from the device's SSE stream until it closes."""
+        # The device sends a keepalive comment every 15 s, so a long silence means it is gone.
+        with requests.get(f"{self.base}/events", stream=True, timeout=(self.timeout, 45.0)) as resp:
+            resp.raise_for_status()
+            yield from parse_sse(resp.iter_lines(decode_unicode=True))
+
+
+class Batch:
+    """Collects operations for one POST /batch; the device applies all or none.
+
+    client.batch().emotion("happy").speak("Standup in 5").reminder(5, "Standup").send()
+    """
+
+    MAX_OPS = 16
+
+    def __init__(self, client: CompanionClient) -> None:
+        self.client = client
+        self.ops: list[dict[str, Any]] = []
+
+    def _add(self, op: str, **fields: Any) -> "Batch":
+        if len(self.ops) >= self.MAX_OPS:
+            raise ValueError(f"a batch holds at most {self.MAX_OPS} operations")
+        self.ops.append({"op": op, **fields})
+        return self
+
+    def emotion(self, emotion: str) -> "Batch":
+        return self._add("emotion", emotion=emotion)
+
+    def speak(self, text: str) -> "Batch":
+        return self._add("speak", text=text)
+
+    def note(self, note: str) -> "Batch":
+        return self._add("note", note=note)
+
+    def reminder(self, minutes: int, message: str) -> "Batch":
+        return self._add("reminder", minutes=minutes, message=message)
+
+    def reminder_at(self, at: str, message: str) -> "Batch":
+        return self._add("reminder", at=at, message=message)
+
+    def reminder_cron(self, cron: str, message: str) -> "Batch":
+        return self._add("reminder", cron=cron, message=message)
+
+    def mode(self, mode: str) -> "Batch":
+        return self._add("mode", mode=mode)
+
+    def clear(self) -> "Batch":
+        return self._add("clear")
+
+    def send(self) -> dict[str, Any]:
+        return self.client.send_batch(self.ops)
+
+
+UDP_CONTROL_PORT = 3130
+UDP_MAX_SPEECH = 160
+UDP_EMOTION, UDP_GAZE, UDP_SPEECH, UDP_GAZE_RELEASE = 0x01, 0x02, 0x04, 0x08
+
+
+def encode_control_packet(
+    session: int,
+    seq: int,
+    emotion: str | None = None,
+    gaze: tuple[int, int] | None = None,
+    speech: str | None = None,
+    release_gaze: bool = False,
+) -> bytes:
+    """One UDP control datagram; the layout is documented in src/udp_control.h."""
+    flags = 0
+    body = b""
+    if emotion is not None:
+        flags |= UDP_EMOTION
+        body += bytes([EMOTIONS.index(emotion)])
+    if gaze is not None:
+        flags |= UDP_GAZE
+        body += struct.pack("<bb", *(max(-127, min(127, v)) for v in gaze))
+    if speech is not None:
+        text = speech.encode("utf-8")[:UDP_MAX_SPEECH]
+        flags |= UDP_SPEECH
+        body += bytes([len(text)]) + text
+    if release_gaze:
+        flags |= UDP_GAZE_RELEASE
+    return b"C3" + struct.pack("<BBHI", 1, flags, session & 0xFFFF, seq & 0xFFFFFFFF) + body
+
+
+class UdpController:
+    """Fire-and-forget control for high-rate updates (no replies, no retries).
+
+    Each instance is its own session, so whichever controller sent last wins.
+    """
+
+    def __init__(self, host: str, port: int = UDP_CONTROL_PORT) -> None:
+        self.addr = (host.split(":")[0], port)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.session = random.getrandbits(16)
+        self.seq = 0
+
+    def send(self, **fields: Any) -> None:
+        self.seq += 1
+        self.sock.sendto(encode_control_packet(self.session, self.seq, **fields), self.addr)
+
+    def close(self) -> None:
+        self.sock.close()
+
+
+def sweep_gaze(controller: UdpController, seconds: float, rate: float) -> None:
+    period = 1.0 / max(1.0, rate)
+    started = time.monotonic()
+    while (elapsed := time.monotonic() - started) < seconds:
+        controller.send(gaze=(round(7 * math.sin(elapsed * 2.0)), round(3 * math.sin(elapsed * 3.1))))
+        time.sleep(period)
+    controller.send(release_gaze=True)
+
+
+def parse_sse(lines: Iterable[str]) -> Iterator[tuple[str, dict[str, Any]]]:
+    event, data = "message", []
+    for line in lines:
+        if line == "":
+            if data:
+                yield event, json.loads("\n".join(data))
+            event, data = "message", []
+        elif line.startswith(":"):
+            continue  # keepalive comment
+        elif line.startswith("event:"):
+            event = line[6:].strip()
+        elif line.startswith("data:"):
+            data.append(line[5:].lstrip())
+
+
+def watch_events(client: CompanionClient) -> None:
+    delay = 1.0
+    while True:
+        try:
+            for event, data in client.events():
+                delay = 1.0
+                print(json.dumps({"event": event, "data": data}, sort_keys=True), flush=True)
+            print("Event stream closed, reconnecting", file=sys.stderr)
+        except requests.HTTPError:
+            raise
+        except requests.RequestException as exc:
+            print(f"Event stream lost ({exc}), retrying in {delay:.0f}s", file=sys.stderr)
+        time.sleep(delay)
+        delay = min(delay * 2, 10.0)
+
+
+def watch_status(client: CompanionClient, interval: float) -> None:
+    status = client.status()
+    print_json(status)
+    while True:
+        time.sleep(max(0.25, interval))
+        delta = client.status_since(status["state_version"])
+        if delta["boot_id"] != status["boot_id"] or "changed" not in delta:
+            # Rebooted: versions restarted, so start again from a full document.
+            status = client.status()
+            print_json(status)
+            continue
+        status["state_version"] = delta["state_version"]
+        if delta["changed"]:
+            print_json(delta)
+
+
+def run_json_bench(client: CompanionClient) -> int:
+    bench = client.json_bench()
+    print(f"iterations {bench['iterations']}")
+    for case in bench["cases"]:
+        print(f"{case['name']}{'' if case['same_size'] else ' (sizes differ)'}")
+        for path in ("document", "streaming"):
+            item = case[path]
+            allocs = f" allocs={item['allocations']}" if "allocations" in item else ""
+            print(
+                f"  {path:9} avg={item['avg_us']:6} us max={item['max_us']:6} us bytes={item['bytes']:5} "
+                f"peak_heap={item['peak_heap_bytes']:6}{allocs}"
+            )
+    return 0
+
 
 def print_json(payload: dict[str, Any]) -> None:
     print(json.dumps(payload, indent=2, sort_keys=True))
@@ -59,9 +293,10 @@ def build_parser() -> argparse.ArgumentParser:
     sub = parser.add_subparsers(dest="command", required=True)
 
     sub.add_parser("status", help="Read current companion state")
+    sub.add_parser("stats", help="Read diagnostic counters (weather, loop, UDP, rate limits, persistence, power)")
 
     emo = sub.add_parser("emotion", help="Set active emotion")
-    emo.add_argument("name", choices=["neutral", "happy", "sad", "sleepy", "angry", "surprised", "thinking"])
+    emo.add_argument("name", choices=EMOTIONS)
 
     speak = sub.add_parser("speak", help="Set speech line on OLED")
     speak.add_argument("text")
@@ -69,15 +304,55 @@ def build_parser() -> argparse.ArgumentParser:
     note = sub.add_parser("note", help="Add note")
     note.add_argument("text")
 
+    notes = sub.add_parser("notes", help="List notes, newest first")
+    notes.add_argument("--offset", type=int, default=0)
+    notes.add_argument("--limit", type=int, default=20)
+
     rem = sub.add_parser("reminder", help="Add reminder in minutes")
     rem.add_argument("minutes", type=int)
     rem.add_argument("message")
 
-    watch = sub.add_parser("watch", help="Watch status updates")
-    watch.add_argument("--interval", type=float, default=2.0)
+    rem_at = sub.add_parser("reminder-at", help="Add reminder at a local HH:MM or YYYY-MM-DDTHH:MM")
+    rem_at.add_argument("at")
+    rem_at.add_argument("message")
+
+    rem_cron = sub.add_parser("reminder-cron", help="Add recurring reminder, e.g. \"30 9 * * 1-5\"")
+    rem_cron.add_argument("cron")
+    rem_cron.add_argument("message")
+
+    sub.add_parser("reminders", help="List pending reminders, soonest first")
+
+    cancel = sub.add_parser("reminder-cancel", help="Cancel a reminder by id")
+    cancel.add_argument("id", type=int)
+
+    edit = sub.add_parser("reminder-edit", help="Change a reminder's time and/or message")
+    edit.add_argument("id", type=int)
+    when = edit.add_mutually_exclusive_group()
+    when.add_argument("--minutes", type=int, help="New deadline, minutes from now")
+    when.add_argument("--at", help="New local time, HH:MM or YYYY-MM-DDTHH:MM")
+    when.add_argument("--cron", help="New recurring schedule")
+    edit.add_argument("--message")
+
+    watch = sub.add_parser("watch", help="Stream state changes as they happen")
+    watch.add_argument("--poll", action="store_true", help="Poll /status instead of using /events")
+    watch.add_argument("--interval", type=float, default=2.0, help="Poll interval with --poll")
 
     sub.add_parser("clear", help="Clear notes/reminders")
 
+    batch = sub.add_parser("batch", help="Apply a JSON list of operations in one request")
+    batch.add_argument("file", help='JSON file with [{"op":"emotion","emotion":"happy"}, ...], or - for stdin')
+
+    sub.add_parser("json-bench", help="Compare JSON serialization paths on a -DJSON_BENCH build")
+
+    udp = sub.add_parser("udp", help="Send state over the low-latency UDP channel")
+    udp.add_argument("--port", type=int, default=UDP_CONTROL_PORT)
+    udp.add_argument("--emotion", choices=EMOTIONS)
+    udp.add_argument("--gaze", type=int, nargs=2, metavar=("X", "Y"), help="Pupil offset, x -7..7, y -3..3")
+    udp.add_argument("--speak", help="Speech line")
+    udp.add_argument("--release-gaze", action="store_true", help="Return the eyes to the idle animation")
+    udp.add_argument("--sweep", type=float, metavar="SECONDS", help="Sweep the gaze around for this long")
+    udp.add_argument("--rate", type=float, default=30.0, help="Updates per second with --sweep")
+
     return parser
 
 
@@ -90,20 +365,64 @@ def main() -> int:
     try:
         if args.command == "status":
             print_json(client.status())
+        elif args.command == "stats":
+            print_json(client.stats())
         elif args.command == "emotion":
             print_json(client.emotion(args.name))
         elif args.command == "speak":
             print_json(client.speak(args.text))
         elif args.command == "note":
             print_json(client.add_note(args.text))
+        elif args.command == "notes":
+            print_json(client.notes(args.offset, args.limit))
         elif args.command == "reminder":
             print_json(client.add_reminder(args.minutes, args.message))
+        elif args.command == "reminder-at":
+            print_json(client.add_reminder_at(args.at, args.message))
+        elif args.command == "reminder-cron":
+            print_json(client.add_recurring_reminder(args.cron, args.message))
+        elif args.command == "reminders":
+            print_json(client.reminders())
+        elif args.command == "reminder-cancel":
+            print_json(client.cancel_reminder(args.id))
+        elif args.command == "reminder-edit":
+            if args.minutes is None and args.at is None and args.cron is None and args.message is None:
+                parser.error("reminder-edit needs --minutes, --at or --cron and/or --message")
+            print_json(client.edit_reminder(args.id, args.minutes, args.message, args.at, args.cron))
         elif args.command == "watch":
-            while True:
-                print_json(client.status())
-                time.sleep(max(0.25, args.interval))
+            if args.poll:
+                watch_status(client, args.interval)
+            else:
+                watch_events(client)
         elif args.command == "clear":
             print_json(client.clear())
+        elif args.command == "batch":
+            if args.file == "-":
+                ops = json.load(sys.stdin)
+            else:
+                with open(args.file, encoding="utf-8") as fh:
+                    ops = json.load(fh)
+            result = client.send_batch(ops)
+            print_json(result)
+            return 0 if result.get("ok") else 1
+        elif args.command == "json-bench":
+            return run_json_bench(client)
+        elif args.command == "udp":
+            controller = UdpController(args.host, args.port)
+            fields: dict[str, Any] = {}
+            if args.emotion:
+                fields["emotion"] = args.emotion
+            if args.gaze:
+                fields["gaze"] = tuple(args.gaze)
+            if args.speak is not None:
+                fields["speech"] = args.speak
+            if args.release_gaze:
+                fields["release_gaze"] = True
+            if fields:
+                controller.send(**fields)
+            if args.sweep:
+                sweep_gaze(controller, args.sweep, args.rate)
+            controller.close()
         else:
             parser.print_help()
             return 2
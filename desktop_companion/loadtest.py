@@ -0,0 +1,283 @@
+#!/usr/bin/env python3
+"""HTTP load test for the Companion 313 API.
+
+Drives a weighted mix of requests at a target rate over N concurrent
+connections and prints latency percentiles and error rates as JSON, e.g.
+
+    python3 loadtest.py --host 192.168.4.1 --rate 20 --concurrency 4 --duration 30
+    python3 loadtest.py --host 127.0.0.1:8313 --mix status=8,emotion=2 --out run.json
+
+Requests are scheduled open-loop: request k is due at start + k / rate. Two
+numbers are recorded per request. `latency_ms` runs from send to full
+response. `response_ms` runs from the scheduled time, so it includes time
+spent waiting behind a slow device instead of hiding it.
+"""
+
+from __future__ import annotations
+
+import argparse
+import http.client
+import itertools
+import json
+import math
+import random
+import sys
+import threading
+import time
+from dataclasses import dataclass, field
+from typing import Any
+
+from app import EMOTIONS
+
+DEFAULT_MIX = "status=6,root=1,emotion=1,speak=1,notes=1,reminders=0"
+
+
+@dataclass
+class Op:
+    method: str
+    path: str
+    body: Any = None
+
+
+def make_op(name: str, n: int) -> Op:
+    if name == "status":
+        return Op("GET", "/status")
+    if name == "root":
+        return Op("GET", "/")
+    if name == "emotion":
+        return Op("POST", "/emotion", {"emotion": EMOTIONS[n % len(EMOTIONS)]})
+    if name == "speak":
+        return Op("POST", "/speak", {"text": f"load {n}"})
+    if name == "notes":
+        return Op("POST", "/notes", {"note": f"load note {n}"})
+    if name == "reminders":
+        return Op("POST", "/reminders", {"minutes": 60, "message": f"load {n}"})
+    raise ValueError(f"unknown op {name!r}")
+
+
+OP_NAMES = ["status", "root", "emotion", "speak", "notes", "reminders"]
+
+
+def parse_mix(spec: str) -> dict[str, float]:
+    mix: dict[str, float] = {}
+    for part in spec.split(","):
+        if not part.strip():
+            continue
+        name, _, weight = part.partition("=")
+        name = name.strip()
+        if name not in OP_NAMES:
+            raise ValueError(f"unknown op {name!r} (expected one of {', '.join(OP_NAMES)})")
+        mix[name] = float(weight or 1)
+    if not any(w > 0 for w in mix.values()):
+        raise ValueError("mix has no op with a positive weight")
+    return {k: v for k, v in mix.items() if v > 0}
+
+
+@dataclass
+class OpStats:
+    latency_ms: list[float] = field(default_factory=list)
+    response_ms: list[float] = field(default_factory=list)
+    statuses: dict[str, int] = field(default_factory=dict)
+    errors: int = 0  # non-2xx/304 responses and transport failures
+    rejected: int = 0  # 429 from admission control, also counted in errors
+
+
+def percentile(sorted_values: list[float], pct: float) -> float:
+    """Nearest-rank percentile of an already sorted list."""
+    if not sorted_values:
+        return 0.0
+    rank = max(1, math.ceil(pct / 100.0 * len(sorted_values)))
+    return sorted_values[min(rank, len(sorted_values)) - 1]
+
+
+def summarize(values: list[float]) -> dict[str, float]:
+    ordered = sorted(values)
+    return {
+        "p50": round(percentile(ordered, 50), 2),
+        "p95": round(percentile(ordered, 95), 2),
+        "p99": round(percentile(ordered, 99), 2),
+        "max": round(ordered[-1], 2) if ordered else 0.0,
+        "mean": round(sum(ordered) / len(ordered), 2) if ordered else 0.0,
+    }
+
+
+class LoadTest:
+    def __init__(self, host: str, mix: dict[str, float], rate: float, duration: float,
+                 concurrency: int, timeout: float, seed: int | None) -> None:
+        self.host = host
+        self.mix = mix
+        self.rate = rate
+        self.duration = duration
+        self.concurrency = concurrency
+        self.timeout = timeout
+        self.rng = random.Random(seed)
+        self.lock = threading.Lock()
+        self.counter = itertools.count()
+        self.stats = {name: OpStats() for name in mix}
+        self.start = 0.0
+        self.started_at = ""
+
+    def next_request(self) -> tuple[int, float, str] | None:
+        """Claims the next request slot: (index, due time, op name), or None when done."""
+        with self.lock:
+            k = next(self.counter)
+            if self.rate > 0:
+                offset = k / self.rate
+            else:
+                offset = time.monotonic() - self.start  # closed loop: due now
+            if offset >= self.duration:
+                return None
+            due = self.start + offset
+            name = self.rng.choices(list(self.mix), weights=list(self.mix.values()))[0]
+        return k, due, name
+
+    def send(self, op: Op) -> int:
+        conn = http.client.HTTPConnection(self.host, timeout=self.timeout)
+        try:
+            headers = {"Connection": "close"}
+            payload = None
+            if op.body is not None:
+                payload = json.dumps(op.body)
+                headers["Content-Type"] = "application/json"
+            conn.request(op.method, op.path, body=payload, headers=headers)
+            resp = conn.getresponse()
+            resp.read()
+            return resp.status
+        finally:
+            conn.close()
+
+    def worker(self) -> None:
+        while (slot := self.next_request()) is not None:
+            k, due, name = slot
+            delay = due - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            sent = time.monotonic()
+            try:
+                status = str(self.send(make_op(name, k)))
+            except (OSError, http.client.HTTPException) as exc:
+                status = type(exc).__name__
+            done = time.monotonic()
+            with self.lock:
+                stats = self.stats[name]
+                stats.latency_ms.append((done - sent) * 1000.0)
+                stats.response_ms.append((done - max(due, self.start)) * 1000.0)
+                stats.statuses[status] = stats.statuses.get(status, 0) + 1
+                if status == "429":
+                    stats.rejected += 1
+                if not (status.startswith("2") or status == "304"):
+                    stats.errors += 1
+
+    def run(self) -> dict[str, Any]:
+        self.started_at = time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime())
+        self.start = time.monotonic()
+        threads = [threading.Thread(target=self.worker, daemon=True) for _ in range(self.concurrency)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        elapsed = time.monotonic() - self.start
+        return self.report(elapsed)
+
+    def report(self, elapsed: float) -> dict[str, Any]:
+        ops: dict[str, Any] = {}
+        all_latency: list[float] = []
+        all_response: list[float] = []
+        total = errors = rejected = 0
+        for name, s in self.stats.items():
+            count = len(s.latency_ms)
+            total += count
+            errors += s.errors
+            rejected += s.rejected
+            all_latency += s.latency_ms
+            all_response += s.response_ms
+            ops[name] = {
+                "count": count,
+                "errors": s.errors,
+                "rejected": s.rejected,
+                "error_rate": round(s.errors / count, 4) if count else 0.0,
+                "statuses": dict(sorted(s.statuses.items())),
+                "latency_ms": summarize(s.latency_ms),
+                "response_ms": summarize(s.response_ms),
+            }
+        return {
+            "host": self.host,
+            "started_at": self.started_at,
+            "config": {
+                "rate": self.rate,
+                "duration_s": self.duration,
+                "concurrency": self.concurrency,
+                "mix": self.mix,
+            },
+            "elapsed_s": round(elapsed, 3),
+            "requests": total,
+            "achieved_rate": round(total / elapsed, 2) if elapsed > 0 else 0.0,
+            "errors": errors,
+            "rejected": rejected,
+            "error_rate": round(errors / total, 4) if total else 0.0,
+            "latency_ms": summarize(all_latency),
+            "response_ms": summarize(all_response),
+            "ops": ops,
+        }
+
+
+def compare(result: dict[str, Any], baseline: dict[str, Any], tolerance: float) -> list[str]:
+    """Ops whose p95 latency or error rate got worse than the baseline allows."""
+    problems = []
+    for name, op in result["ops"].items():
+        base = baseline.get("ops", {}).get(name)
+        if not base:
+            continue
+        base_p95, p95 = base["latency_ms"]["p95"], op["latency_ms"]["p95"]
+        if base_p95 > 0 and p95 > base_p95 * (1.0 + tolerance):
+            problems.append(f"{name}: p95 {p95} ms vs baseline {base_p95} ms")
+        if op["error_rate"] > base["error_rate"] + 0.01:
+            problems.append(f"{name}: error rate {op['error_rate']} vs baseline {base['error_rate']}")
+    return problems
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Load-test the companion HTTP API")
+    parser.add_argument("--host", default="192.168.4.1", help="Device or stand-in host[:port]")
+    parser.add_argument("--mix", default=DEFAULT_MIX, help=f"Weighted ops (default: {DEFAULT_MIX})")
+    parser.add_argument("--rate", type=float, default=10.0, help="Target requests/s overall; 0 = as fast as possible")
+    parser.add_argument("--duration", type=float, default=20.0, help="Seconds to run")
+    parser.add_argument("--concurrency", type=int, default=2, help="Concurrent connections")
+    parser.add_argument("--timeout", type=float, default=5.0, help="Per-request timeout in seconds")
+    parser.add_argument("--seed", type=int, help="Seed for the op mix")
+    parser.add_argument("--clear", action="store_true", help="POST /clear afterwards to drop load-test notes")
+    parser.add_argument("--out", help="Also write the JSON result to this file")
+    parser.add_argument("--baseline", help="Fail if p95 or error rate regressed against this result file")
+    parser.add_argument("--tolerance", type=float, default=0.25, help="Allowed p95 growth with --baseline")
+    args = parser.parse_args()
+
+    try:
+        mix = parse_mix(args.mix)
+    except ValueError as exc:
+        parser.error(str(exc))
+
+    test = LoadTest(args.host, mix, args.rate, args.duration, max(1, args.concurrency), args.timeout, args.seed)
+    result = test.run()
+    if args.clear:
+        try:
+            test.send(Op("POST", "/clear", {}))
+        except (OSError, http.client.HTTPException) as exc:
+            print(f"clear failed: {exc}", file=sys.stderr)
+
+    text = json.dumps(result, indent=2, sort_keys=True)
+    print(text)
+    if args.out:
+        with open(args.out, "w", encoding="utf-8") as fh:
+            fh.write(text + "\n")
+
+    if args.baseline:
+        with open(args.baseline, encoding="utf-8") as fh:
+            problems = compare(result, json.load(fh), args.tolerance)
+        for problem in problems:
+            print(f"regression: {problem}", file=sys.stderr)
+        return 1 if problems else 0
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
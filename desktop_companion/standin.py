@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+"""Stand-in for the firmware's HTTP API, for exercising loadtest.py and app.py
+without a device.
+
+Like the ESP32 WebServer it serves one request at a time, and --service-ms
+adds a fixed per-request cost to mimic the device. State is kept in memory
+with the firmware's limits (256 notes, 256 reminders, 160-character speech).
+
+    python3 standin.py --port 8313 --service-ms 15
+    python3 loadtest.py --host 127.0.0.1:8313 --rate 30 --duration 10
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import time
+from urllib.parse import parse_qs, urlsplit
+from http.server import BaseHTTPRequestHandler, HTTPServer
+from pathlib import Path
+from typing import Any
+
+from app import EMOTIONS
+
+MAX_NOTES = 256
+MAX_NOTE_BYTES = 95
+STATUS_NOTES = 8
+MAX_REMINDERS = 256
+MAX_SPEECH_CHARS = 160
+INDEX_HTML = Path(__file__).resolve().parent.parent / "web" / "index.html"
+
+
+class State:
+    def __init__(self) -> None:
+        self.emotion = "neutral"
+        self.mode = "face"
+        self.speech = "Hello"
+        self.notes: list[str] = []
+        self.reminders: list[dict[str, Any]] = []
+        self.version = 1
+        self.next_reminder_id = 1
+        self.note_seq = 0
+
+    def status(self) -> dict[str, Any]:
+        now = time.monotonic()
+        self.reminders = [r for r in self.reminders if r["due"] > now]
+        return {
+            "state_version": self.version,
+            "emotion": self.emotion,
+            "mode": self.mode,
+            "speech": self.speech,
+            "speech_max_chars": MAX_SPEECH_CHARS,
+            "notes": self.notes[::-1][:STATUS_NOTES],
+            "notes_total": len(self.notes),
+            "reminders": [
+                {"id": r["id"], "message": r["message"], "kind": "relative", "armed": True}
+                for r in sorted(self.reminders, key=lambda r: r["due"])[:8]
+            ],
+            "reminders_total": len(self.reminders),
+        }
+
+    def notes_page(self, path: str) -> tuple[int, dict[str, Any]]:
+        query = parse_qs(urlsplit(path).query)
+        try:
+            offset = int(query.get("offset", ["0"])[0])
+            limit = int(query.get("limit", ["20"])[0])
+        except ValueError:
+            offset, limit = -1, 0
+        if offset < 0 or limit <= 0:
+            return 400, {"error": "Expected offset >= 0 and limit > 0"}
+        limit = min(limit, 50)
+        return 200, {"total": len(self.notes), "capacity": MAX_NOTES, "offset": offset, "limit": limit,
+                     "newest_seq": self.note_seq, "notes": self.notes[::-1][offset:offset + limit]}
+
+    def reminder_list(self, now: float) -> list[dict[str, Any]]:
+        return [
+            {"id": r["id"], "message": r["message"], "ms_remaining": int((r["due"] - now) * 1000)}
+            for r in sorted(self.reminders, key=lambda r: r["due"])
+        ]
+
+
+class Handler(BaseHTTPRequestHandler):
+    server_version = "companion-standin"
+    state = State()
+    service_s = 0.0
+    index_html = b"<!doctype html><title>Companion 313</title>"
+
+    def log_message(self, format: str, *args: Any) -> None:
+        pass
+
+    def send_json(self, code: int, payload: dict[str, Any]) -> None:
+        body = json.dumps(payload).encode("utf-8")
+        self.send_response(code)
+        self.send_header("Content-Type", "application/json")
+        self.send_header("Content-Length", str(len(body)))
+        self.send_header("Connection", "close")
+        self.end_headers()
+        self.wfile.write(body)
+
+    def read_json(self) -> dict[str, Any] | None:
+        length = int(self.headers.get("Content-Length") or 0)
+        try:
+            payload = json.loads(self.rfile.read(length) or b"null")
+        except ValueError:
+            return None
+        return payload if isinstance(payload, dict) else None
+
+    def do_GET(self) -> None:
+        time.sleep(self.service_s)
+        if self.path == "/status":
+            self.send_json(200, self.state.status())
+        elif self.path.split("?")[0] == "/notes":
+            self.send_json(*self.state.notes_page(self.path))
+        elif self.path == "/reminders":
+            self.state.status()  # expire fired reminders
+            self.send_json(200, {"count": len(self.state.reminders), "capacity": MAX_REMINDERS,
+                                 "reminders": self.state.reminder_list(time.monotonic())})
+        elif self.path == "/":
+            self.send_response(200)
+            self.send_header("Content-Type", "text/html")
+            self.send_header("Content-Length", str(len(self.index_html)))
+            self.send_header("Connection", "close")
+            self.end_headers()
+            self.wfile.write(self.index_html)
+        else:
+            self.send_json(404, {"error": "Not found"})
+
+    def do_POST(self) -> None:
+        time.sleep(self.service_s)
+        body = self.read_json()
+        state = self.state
+        if body is None:
+            self.send_json(400, {"error": "Expected JSON body"})
+            return
+        if self.path == "/emotion":
+            if body.get("emotion") not in EMOTIONS:
+                self.send_json(400, {"error": "Invalid emotion"})
+                return
+            state.emotion = body["emotion"]
+            self.send_json(200, {"ok": True, "emotion": state.emotion})
+        elif self.path == "/speak":
+            if not isinstance(body.get("text"), str):
+                self.send_json(400, {"error": "Expected {\"text\": ...}"})
+                return
+            state.speech = body["text"][:MAX_SPEECH_CHARS]
+            self.send_json(200, {"ok": True})
+        elif self.path == "/notes":
+            if not isinstance(body.get("note"), str):
+                self.send_json(400, {"error": "Expected {\"note\": ...}"})
+                return
+            note = body["note"].encode()[:MAX_NOTE_BYTES].decode(errors="ignore")
+            state.notes = (state.notes + [note])[-MAX_NOTES:]
+            state.note_seq += 1
+            self.send_json(200, {"ok": True, "count": len(state.notes)})
+        elif self.path == "/reminders":
+            if not isinstance(body.get("minutes"), int) or body["minutes"] <= 0:
+                self.send_json(400, {"error": "Expected {\"minutes\": >0, \"message\": ...}"})
+                return
+            state.status()  # expire fired reminders
+            if len(state.reminders) >= MAX_REMINDERS:
+                self.send_json(507, {"error": "Reminder storage full"})
+                return
+            due = time.monotonic() + body["minutes"] * 60
+            reminder_id = state.next_reminder_id
+            state.next_reminder_id += 1
+            state.reminders.append({"id": reminder_id, "message": str(body.get("message", "")), "due": due})
+            self.send_json(200, {"ok": True, "id": reminder_id})
+        elif self.path == "/clear":
+            state.notes.clear()
+            state.reminders.clear()
+            state.speech = "Cleared"
+            self.send_json(200, {"ok": True})
+        else:
+            self.send_json(404, {"error": "Not found"})
+            return
+        state.version += 1
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Serve a stand-in of the companion HTTP API")
+    parser.add_argument("--bind", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8313)
+    parser.add_argument("--service-ms", type=float, default=0.0, help="Added cost per request")
+    args = parser.parse_args()
+
+    Handler.service_s = args.service_ms / 1000.0
+    if INDEX_HTML.exists():
+        Handler.index_html = INDEX_HTML.read_bytes()
+    server = HTTPServer((args.bind, args.port), Handler)
+    print(f"stand-in listening on http://{args.bind}:{args.port}")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
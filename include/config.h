@@ -17,5 +17,54 @@
 #define OLED_SCL_PIN 9
 #define OLED_I2C_ADDRESS 0x3C
 
+// Scroll long speech with the one-column content scroll command (2Dh) so each
+// marquee step sends one tile instead of the whole speech row. Only SSD1306B
+// and SSD1309-class controllers have it; the original SSD1306 ignores it or
+// scrolls wrongly. Set to 1 if your panel's controller supports it.
+#define OLED_HW_SCROLL 0
+
 // Optional: physical button to cycle emotions (set to -1 to disable).
 #define EMOTION_BUTTON_PIN -1
+
+// RAM budget for pre-rendered face frames (1 KB each, LRU). Set to 0 to disable.
+#define FACE_FRAME_CACHE_BYTES 16384
+
+// Power governor: seconds without interaction (API changes, button, reminders)
+// before dropping to a reduced frame rate, dimming, and finally switching the
+// panel off and lowering the CPU clock. Set a step to 0 to skip it.
+#define POWER_REDUCED_AFTER_S 60
+#define POWER_DIM_AFTER_S 300
+#define POWER_OFF_AFTER_S 1800
+
+// Number of pending reminders (about 220 bytes of RAM each).
+#define REMINDER_CAPACITY 256
+
+// Number of notes kept, newest first; the oldest is dropped when full
+// (100 bytes of RAM each, text up to 95 bytes).
+#define NOTE_CAPACITY 256
+
+// Notes, reminders, emotion and Info settings survive reboots in a LittleFS
+// log (see src/persist.h). Changes are written once they pause for QUIET_MS,
+// or after MAX_DELAY_MS at the latest; the log is compacted once it exceeds
+// twice its last snapshot plus COMPACT_SLACK_BYTES. Set ENABLED to 0 to keep
+// everything in RAM.
+#define PERSIST_ENABLED 1
+#define PERSIST_QUIET_MS 2000
+#define PERSIST_MAX_DELAY_MS 10000
+#define PERSIST_COMPACT_SLACK_BYTES 8192
+
+// Binary UDP control channel for high-rate emotion/gaze/speech updates
+// (see src/udp_control.h). Set to 0 to disable.
+#define UDP_CONTROL_PORT 3130
+
+// HTTP admission control: sustained requests per second and burst size per
+// client IP for each route class, and for all clients together. Over the limit
+// a request gets 429 with Retry-After. Set a rate to 0 to disable that limit.
+#define RATE_READ_PER_S 5
+#define RATE_READ_BURST 10
+#define RATE_MUTATE_PER_S 10
+#define RATE_MUTATE_BURST 20
+#define RATE_UI_PER_S 5
+#define RATE_UI_BURST 10
+#define RATE_GLOBAL_PER_S 30
+#define RATE_GLOBAL_BURST 40
@@ -0,0 +1,99 @@
+"""Gzip the control panel in web/ into include/web_assets.h.
+
+Runs before each PlatformIO build (extra_scripts = pre:scripts/embed_web.py)
+and can also be run directly: python scripts/embed_web.py
+
+index.html may reference the other assets as {{name}}; each reference is
+replaced with /name?v=<hash> so those files can be cached indefinitely.
+"""
+
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+    PROJECT_DIR = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB_DIR = os.path.join(PROJECT_DIR, "web")
+OUT_PATH = os.path.join(PROJECT_DIR, "include", "web_assets.h")
+
+# (file, URL path, content type, immutable). Immutable files are only ever
+# requested with a ?v=<hash> query, so they get a year-long max-age.
+ASSETS = [
+    ("panel.css", "/panel.css", "text/css", True),
+    ("panel.js", "/panel.js", "application/javascript", True),
+    ("index.html", "/", "text/html", False),
+]
+
+
+def content_hash(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def c_identifier(name):
+    return "kWeb_" + "".join(c if c.isalnum() else "_" for c in name)
+
+
+def c_bytes(data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "\n".join(lines)
+
+
+def build():
+    hashes = {}
+    entries = []
+    arrays = []
+    for name, url, content_type, immutable in ASSETS:
+        with open(os.path.join(WEB_DIR, name), "rb") as f:
+            raw = f.read()
+        for other, other_hash in hashes.items():
+            other_url = next(a[1] for a in ASSETS if a[0] == other)
+            raw = raw.replace(("{{%s}}" % other).encode(), ("%s?v=%s" % (other_url, other_hash)).encode())
+        digest = content_hash(raw)
+        hashes[name] = digest
+        # mtime=0 keeps the output byte-identical between builds.
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        ident = c_identifier(name)
+        arrays.append("// %s: %d bytes, %d gzipped\nstatic const uint8_t %s[] PROGMEM = {\n%s\n};\n"
+                      % (name, len(raw), len(packed), ident, c_bytes(packed)))
+        entries.append('    {"%s", "%s", %s, sizeof(%s), "\\"%s\\"", %s},'
+                       % (url, content_type, ident, ident, digest, "true" if immutable else "false"))
+
+    out = [
+        "// Generated by scripts/embed_web.py from web/. Do not edit.",
+        "#pragma once",
+        "#include <Arduino.h>",
+        "",
+        "struct WebAsset {",
+        "  const char* path;",
+        "  const char* contentType;",
+        "  const uint8_t* gzipData;",
+        "  size_t gzipLength;",
+        "  const char* etag;",
+        "  bool immutable;",
+        "};",
+        "",
+    ]
+    out.extend(arrays)
+    out.append("static const WebAsset kWebAssets[] = {")
+    out.extend(entries)
+    out.append("};")
+    out.append("")
+    text = "\n".join(out)
+
+    old = None
+    if os.path.exists(OUT_PATH):
+        with open(OUT_PATH) as f:
+            old = f.read()
+    if old != text:
+        with open(OUT_PATH, "w") as f:
+            f.write(text)
+        print("embed_web: wrote %s" % os.path.relpath(OUT_PATH, PROJECT_DIR))
+
+
+build()
@@ -0,0 +1,75 @@
+#include "chunked_writer.h"
+
+void ChunkedWriter::begin(int statusCode, const char* contentType) {
+  web.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  web.send(statusCode, contentType, "");
+  started = true;
+}
+
+void ChunkedWriter::end() {
+  if (!started || ended) return;
+  sendBuffered();
+  // Zero-length chunk closes the body.
+  web.sendContent("");
+  ended = true;
+}
+
+void ChunkedWriter::sendBuffered() {
+  if (length == 0) return;
+  web.sendContent(buffer, length);
+  length = 0;
+}
+
+size_t ChunkedWriter::write(uint8_t c) {
+  if (length == kBufferBytes) sendBuffered();
+  buffer[length++] = static_cast<char>(c);
+  total++;
+  return 1;
+}
+
+size_t ChunkedWriter::write(const uint8_t* data, size_t len) {
+  size_t remaining = len;
+  while (remaining > 0) {
+    if (length == kBufferBytes) sendBuffered();
+    size_t n = kBufferBytes - length;
+    if (n > remaining) n = remaining;
+    memcpy(buffer + length, data, n);
+    length += n;
+    data += n;
+    remaining -= n;
+  }
+  total += len;
+  return len;
+}
+
+void ChunkedWriter::writeEscaped(const char* text) {
+  const char* run = text;
+  for (const char* p = text;; ++p) {
+    const char* entity = nullptr;
+    switch (*p) {
+      case '&':
+        entity = "&amp;";
+        break;
+      case '<':
+        entity = "&lt;";
+        break;
+      case '>':
+        entity = "&gt;";
+        break;
+      case '"':
+        entity = "&quot;";
+        break;
+      case '\'':
+        entity = "&#39;";
+        break;
+      case '\0':
+        write(run, static_cast<size_t>(p - run));
+        return;
+      default:
+        continue;
+    }
+    write(run, static_cast<size_t>(p - run));
+    write(entity);
+    run = p + 1;
+  }
+}
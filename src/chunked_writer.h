@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include <WebServer.h>
+
+// Streams a response body with chunked transfer encoding through a small
+// fixed buffer, so a large page never needs one contiguous heap block and the
+// first bytes leave as soon as the buffer fills. Lives on the handler's stack.
+class ChunkedWriter : public Print {
+ public:
+  static constexpr size_t kBufferBytes = 512;
+
+  explicit ChunkedWriter(WebServer& target) : web(target) {}
+  ~ChunkedWriter() { end(); }
+
+  // Sends the status line and headers. Call once before writing the body.
+  void begin(int statusCode, const char* contentType);
+  // Sends whatever is buffered plus the terminating chunk. Safe to repeat.
+  void end();
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* data, size_t len) override;
+  using Print::write;
+
+  // Writes text with &, <, >, " and ' replaced by HTML entities.
+  void writeEscaped(const char* text);
+  void writeEscaped(const String& text) { writeEscaped(text.c_str()); }
+
+  size_t bytesWritten() const { return total; }
+
+ private:
+  void sendBuffered();
+
+  WebServer& web;
+  char buffer[kBufferBytes];
+  size_t length = 0;
+  size_t total = 0;
+  bool started = false;
+  bool ended = false;
+};
@@ -1,6 +1,7 @@
 #include "display.h"
 #include "weather.h"
 #include "time_sync.h"
+#include "power.h"
 
 // State owned by main.cpp
 extern Emotion currentEmotion;
@@ -13,6 +14,7 @@ uint32_t nextBlinkMs = 0;
 uint32_t blinkUntilMs = 0;
 uint32_t nextFaceRefreshMs = 0;
 bool blinkClosed = false;
+bool displayDirty = true;
 
 void scheduleBlink(uint32_t now) {
   // Slightly irregular blink interval feels less robotic.
@@ -106,222 +108,250 @@ void drawMoonIcon(int x, int y) {
   display.drawCircle(cx, cy, 4);
 }
 
-void drawEyes(int y, int h, int curve, bool closed) {
-  const int leftX = 30;
-  const int rightX = 78;
-  const int eyeW = 20;
+// Speech wider than the screen scrolls as a marquee on the bottom page.
+static constexpr uint32_t kSpeechMarqueeHoldMs = 1000UL;
+static constexpr uint32_t kSpeechMarqueeStepMs = 40UL;
+static constexpr int kSpeechMarqueeGap = 24;
+static constexpr int kSpeechMarqueeBaselineY = 63;  // keeps the glyphs inside page 7
 
-  if (closed) {
-    display.drawHLine(leftX, y + h / 2, eyeW);
-    display.drawHLine(rightX, y + h / 2, eyeW);
-    return;
-  }
+static uint32_t marqueeStartMs = 0;
+static int marqueeTextW = 0;  // 0 while the speech fits and stays still
+static int shownMarqueeOffset = -1;
 
-  display.drawRBox(leftX, y, eyeW, h, curve);
-  display.drawRBox(rightX, y, eyeW, h, curve);
+void restartSpeechMarquee() {
+  display.setFont(u8g2_font_5x8_tr);
+  int textW = display.getStrWidth(speechText.c_str());
+  marqueeTextW = textW > kDisplayWidth - 4 ? textW : 0;
+  marqueeStartMs = millis();
+  shownMarqueeOffset = -1;
 }
 
-void drawPupils(int y, int h, int offsetX) {
-  if (h < 8) return;
-  const int leftCenterX = 40 + offsetX;
-  const int rightCenterX = 88 + offsetX;
-  const int centerY = y + h / 2;
-  display.drawDisc(leftCenterX, centerY, 2);
-  display.drawDisc(rightCenterX, centerY, 2);
-  // Tiny glint makes eyes look less flat.
-  display.drawPixel(leftCenterX - 1, centerY - 1);
-  display.drawPixel(rightCenterX - 1, centerY - 1);
+static int speechMarqueeOffset(uint32_t now) {
+  uint32_t elapsed = now - marqueeStartMs;
+  if (elapsed < kSpeechMarqueeHoldMs) return 0;
+  uint32_t period = static_cast<uint32_t>(marqueeTextW + kSpeechMarqueeGap);
+  return static_cast<int>(((elapsed - kSpeechMarqueeHoldMs) / kSpeechMarqueeStepMs) % period);
 }
 
-void drawBrows(int leftX1, int leftY1, int leftX2, int leftY2, int rightX1, int rightY1, int rightX2,
-               int rightY2) {
-  display.drawLine(leftX1, leftY1, leftX2, leftY2);
-  display.drawLine(rightX1, rightY1, rightX2, rightY2);
+static uint32_t untilSpeechMarqueeStepMs(uint32_t now) {
+  uint32_t elapsed = now - marqueeStartMs;
+  if (elapsed < kSpeechMarqueeHoldMs) return kSpeechMarqueeHoldMs - elapsed;
+  return kSpeechMarqueeStepMs - ((elapsed - kSpeechMarqueeHoldMs) % kSpeechMarqueeStepMs);
 }
 
-void drawMouthFlat(int y, int w) {
-  int x = (128 - w) / 2;
-  display.drawHLine(x, y, w);
+void invalidateDisplay() {
+  displayDirty = true;
 }
 
-void drawMouthSmile(int y, int w) {
-  int x = (128 - w) / 2;
-  display.drawLine(x, y, x + w / 2, y + 3);
-  display.drawLine(x + w / 2, y + 3, x + w, y);
-  display.drawPixel(x + 1, y + 1);
-  display.drawPixel(x + w - 1, y + 1);
-}
+uint32_t nextFaceChangeMs(uint32_t now) {
+  // Tweened emotion changes advance one step per frame.
+  if (faceTransitionActive(now)) {
+    return now + kFaceRefreshMs;
+  }
 
-void drawMouthFrown(int y, int w) {
-  int x = (128 - w) / 2;
-  display.drawLine(x, y + 3, x + w / 2, y);
-  display.drawLine(x + w / 2, y, x + w, y + 3);
-  display.drawPixel(x + 1, y + 2);
-  display.drawPixel(x + w - 1, y + 2);
+  // Periods of the animation clocks sampled by currentFaceKey().
+  static const uint32_t kQuanta[] = {220UL, 260UL, 300UL, 400UL};
+  const FaceFrameKey current = currentFaceKey(now);
+
+  // Step through upcoming quantum boundaries until one actually changes the frame.
+  // Blink edges are not predicted here; serviceBlink() invalidates on its own.
+  uint32_t elapsed = 0;
+  for (int step = 0; step < 16; ++step) {
+    uint32_t nextStep = UINT32_MAX;
+    for (size_t i = 0; i < sizeof(kQuanta) / sizeof(kQuanta[0]); ++i) {
+      uint32_t q = kQuanta[i];
+      uint32_t untilBoundary = q - ((now + elapsed) % q);
+      if (untilBoundary < nextStep) nextStep = untilBoundary;
+    }
+    elapsed += nextStep;
+    if (!faceKeysEqual(currentFaceKey(now + elapsed), current)) break;
+  }
+  uint32_t untilGaze = untilGazeReleaseMs(now);
+  if (untilGaze < elapsed) elapsed = untilGaze;
+  if (marqueeTextW > 0) {
+    uint32_t untilStep = untilSpeechMarqueeStepMs(now);
+    if (untilStep < elapsed) elapsed = untilStep;
+  }
+  return now + elapsed;
 }
 
-void drawMouthOpen(int cx, int cy, int r) {
-  display.drawCircle(cx, cy, r);
-  if (r >= 5) {
-    display.drawCircle(cx, cy, r - 1);
+void drawFace() {
+  uint32_t now = millis();
+  FaceFrameKey key = currentFaceKey(now);
+  uint8_t* frame = display.getBufferPtr();
+  if (faceTransitionActive(now)) {
+    // Tween frames are transient, so they bypass the cache.
+    display.clearBuffer();
+    renderFaceParams(faceParamsAt(now), rawFaceKey(now));
+  } else if (!faceCacheLoad(key, frame)) {
+    display.clearBuffer();
+    renderFaceFeatures(key);
+    faceCacheStore(key, frame);
   }
-}
 
-void drawCheeks() {
-  display.drawDisc(22, 42, 1);
-  display.drawDisc(26, 44, 1);
-  display.drawDisc(106, 42, 1);
-  display.drawDisc(102, 44, 1);
+  display.setFont(u8g2_font_5x8_tr);
+  uint8_t scrollSteps = 0;
+  if (marqueeTextW == 0) {
+    display.drawStr(2, 61, speechText.c_str());
+  } else {
+    const int period = marqueeTextW + kSpeechMarqueeGap;
+    const int offset = speechMarqueeOffset(now);
+    if (shownMarqueeOffset >= 0) {
+      int moved = (offset - shownMarqueeOffset + period) % period;
+      scrollSteps = static_cast<uint8_t>(moved > 255 ? 255 : moved);
+    }
+    shownMarqueeOffset = offset;
+    // Negative x wraps in U8g2's unsigned coordinates and is clipped per glyph.
+    const int x = 2 - offset;
+    display.drawStr(x, kSpeechMarqueeBaselineY, speechText.c_str());
+    if (x + period < kDisplayWidth) {
+      display.drawStr(x + period, kSpeechMarqueeBaselineY, speechText.c_str());
+    }
+  }
+
+  flushDisplay(scrollSteps);
 }
 
-void drawThoughtBubble(int wobble) {
-  int baseY = 49 - wobble;
-  display.drawDisc(54, baseY - 5, 1);
-  display.drawDisc(61, baseY - 3, 2);
-  display.drawDisc(71, baseY, 3);
-  display.drawCircle(82, baseY + 2, 5);
-  display.drawCircle(89, baseY + 1, 4);
-  display.drawCircle(94, baseY + 3, 3);
+// Pre-rasterized fub20 glyphs for the Info clock, captured once at startup so the
+// clock is composed with byte copies instead of the font decoder.
+static constexpr char kClockGlyphChars[] = "0123456789:-";
+static constexpr size_t kClockGlyphCount = sizeof(kClockGlyphChars) - 1;
+static constexpr uint8_t kClockGlyphMaxCols = 24;
+static constexpr uint8_t kClockGlyphPages = 4;  // rows 0..31 cover the baseline at y=24
+static constexpr int kClockBaselineY = 24;
+
+struct ClockGlyph {
+  uint8_t advance;
+  uint8_t extent;  // ink width when the glyph ends a string, as getStrWidth() counts it
+  uint8_t pages[kClockGlyphPages][kClockGlyphMaxCols];
+};
+
+static ClockGlyph clockGlyphs[kClockGlyphCount];
+static bool clockAtlasReady = false;
+
+// What the Info screen currently shows; redraws are skipped while it still matches.
+struct InfoContent {
+  bool timeValid;
+  int8_t hour;
+  int8_t minute;
+  bool pm;
+  uint32_t dataRevision;
+};
+
+static InfoContent shownInfoContent;
+static bool infoContentShown = false;
+
+void initInfoClockAtlas() {
+  uint8_t* frame = display.getBufferPtr();
+  display.setFont(u8g2_font_fub20_tf);
+  for (size_t i = 0; i < kClockGlyphCount; ++i) {
+    const char text[2] = {kClockGlyphChars[i], '\0'};
+    ClockGlyph& glyph = clockGlyphs[i];
+    display.clearBuffer();
+    glyph.advance = static_cast<uint8_t>(display.drawGlyph(0, kClockBaselineY, text[0]));
+    glyph.extent = static_cast<uint8_t>(display.getStrWidth(text));
+    for (uint8_t page = 0; page < kClockGlyphPages; ++page) {
+      memcpy(glyph.pages[page], frame + page * kDisplayWidth, kClockGlyphMaxCols);
+    }
+  }
+  display.clearBuffer();
+  clockAtlasReady = true;
 }
 
-void drawSleepZ(int phase) {
-  int y = 10 + phase;
-  display.setFont(u8g2_font_5x8_tr);
-  display.drawStr(95, y, "Z");
-  display.drawStr(104, y + 4, "z");
-  display.drawStr(111, y + 8, "z");
+static const ClockGlyph* findClockGlyph(char c) {
+  for (size_t i = 0; i < kClockGlyphCount; ++i) {
+    if (kClockGlyphChars[i] == c) return &clockGlyphs[i];
+  }
+  return nullptr;
 }
 
-void drawHeart(int cx, int cy, int r) {
-  display.drawDisc(cx - r / 2, cy - r / 2, r / 2 + 1);
-  display.drawDisc(cx + r / 2, cy - r / 2, r / 2 + 1);
-  display.drawTriangle(cx - r - 1, cy - r / 3, cx + r + 1, cy - r / 3, cx, cy + r + 1);
+static bool clockAtlasCovers(const char* text) {
+  if (!clockAtlasReady) return false;
+  for (const char* p = text; *p != '\0'; ++p) {
+    if (findClockGlyph(*p) == nullptr) return false;
+  }
+  return true;
 }
 
-void drawFace() {
-  display.clearBuffer();
+static int clockTextWidth(const char* text) {
+  int width = 0;
+  for (const char* p = text; *p != '\0'; ++p) {
+    const ClockGlyph* glyph = findClockGlyph(*p);
+    width += p[1] == '\0' ? glyph->extent : glyph->advance;
+  }
+  return width;
+}
 
-  bool closed = blinkClosed || currentEmotion == Emotion::Sleepy;
-  uint32_t now = millis();
-  int glance = static_cast<int>((now / 400UL) % 3UL) - 1;  // -1, 0, 1 subtle scanning look
-  int pulse2 = static_cast<int>((now / 220UL) % 2UL);      // 0/1
-  int pulse3 = static_cast<int>((now / 260UL) % 3UL) - 1;  // -1/0/1
-  int bob = static_cast<int>((now / 300UL) % 4UL);         // 0..3
-  int bobY = (bob < 2) ? bob : (3 - bob);                  // 0,1,1,0
-
-  switch (currentEmotion) {
-    case Emotion::Happy:
-      drawEyes(15 + bobY, 15, 5, closed);
-      if (!closed) {
-        drawPupils(15 + bobY, 15, glance);
-      }
-      drawBrows(30, 12 + bobY, 48, 10 + bobY, 78, 10 + bobY, 96, 12 + bobY);
-      drawCheeks();
-      drawMouthSmile(41 + pulse2, 26);
-      break;
-    case Emotion::Sad:
-      drawEyes(18 + pulse2, 10, 4, closed);
-      if (!closed) {
-        drawPupils(18 + pulse2, 10, 0);
-      }
-      drawBrows(28, 11 + pulse2, 48, 16 + pulse2, 80, 16 + pulse2, 100, 11 + pulse2);
-      drawMouthFrown(43 + pulse2, 24);
-      display.drawPixel(25, 36 + (pulse2 * 2));
-      display.drawPixel(103, 36 + ((1 - pulse2) * 2));
-      break;
-    case Emotion::Sleepy:
-      drawEyes(24 + pulse2, 4, 2, true);
-      display.drawLine(30, 20 + pulse2, 50, 20 + pulse2);
-      display.drawLine(78, 20 + pulse2, 98, 20 + pulse2);
-      drawMouthFlat(46 + pulse2, 14);
-      display.drawPixel(63 + pulse2, 50);
-      drawSleepZ(pulse2);
-      break;
-    case Emotion::Angry:
-      drawEyes(18, 12 + pulse2, 2, closed);
-      if (!closed) {
-        drawPupils(18, 12 + pulse2, pulse3);
-      }
-      drawBrows(25, 14 - pulse2, 49, 9 - pulse2, 103, 14 - pulse2, 79, 9 - pulse2);
-      drawMouthFlat(44, 22 + pulse2);
-      display.drawLine(52, 47 + pulse2, 76, 47 + pulse2);
-      display.drawLine(52, 48 + pulse2, 76, 48 + pulse2);
-      break;
-    case Emotion::Surprised:
-      drawEyes(14, 18 + pulse2, 9, closed);
-      if (!closed) {
-        drawPupils(14, 18 + pulse2, 0);
+static void blitClockText(int x, const char* text) {
+  uint8_t* frame = display.getBufferPtr();
+  for (const char* p = text; *p != '\0'; ++p) {
+    const ClockGlyph* glyph = findClockGlyph(*p);
+    for (int col = 0; col < kClockGlyphMaxCols; ++col) {
+      int dstX = x + col;
+      if (dstX < 0 || dstX >= kDisplayWidth) continue;
+      for (uint8_t page = 0; page < kClockGlyphPages; ++page) {
+        frame[page * kDisplayWidth + dstX] |= glyph->pages[page][col];
       }
-      drawBrows(30, 10 - pulse2, 48, 9 - pulse2, 78, 9 - pulse2, 96, 10 - pulse2);
-      drawMouthOpen(64, 45, 5 + pulse2);
-      break;
-    case Emotion::Thinking:
-      drawEyes(17, 11, 4, closed);
-      if (!closed) {
-        drawPupils(17, 11, -1 + pulse2);
-      }
-      drawBrows(29, 12, 47, 11 + pulse2, 78, 12, 97, 14 + pulse2);
-      drawMouthFlat(44, 14);
-      drawThoughtBubble(pulse2);
-      break;
-    case Emotion::Love: {
-      int heartPulse = 5 + pulse2;
-      if (closed) {
-        drawEyes(18, 10, 3, true);
-      } else {
-        drawHeart(40, 24 + bobY, heartPulse);
-        drawHeart(88, 24 + bobY, heartPulse);
-      }
-      drawBrows(30, 12 + bobY, 48, 11 + bobY, 78, 11 + bobY, 96, 12 + bobY);
-      drawCheeks();
-      drawMouthSmile(41 + pulse2, 28);
-      break;
     }
-    case Emotion::Neutral:
-    default:
-      drawEyes(17 + (bobY ? 1 : 0), 12, 5, closed);
-      if (!closed) {
-        drawPupils(17 + (bobY ? 1 : 0), 12, pulse3);
-      }
-      drawBrows(30, 12, 48, 12 + (bobY ? 1 : 0), 78, 12, 96, 12 + (bobY ? 1 : 0));
-      drawMouthFlat(44 + (bobY ? 1 : 0), 18);
-      break;
+    x += glyph->advance;
   }
+}
 
-  display.setFont(u8g2_font_5x8_tr);
-  display.drawStr(2, 61, speechText.c_str());
+static InfoContent currentInfoContent() {
+  InfoContent content;
+  int hour = 0;
+  int minute = 0;
+  content.pm = false;
+  content.timeValid = getLocalTimeParts(hour, minute, content.pm);
+  content.hour = static_cast<int8_t>(hour);
+  content.minute = static_cast<int8_t>(minute);
+  content.dataRevision = infoDataRevision;
+  return content;
+}
 
-  display.sendBuffer();
+bool infoContentChanged() {
+  if (!infoContentShown) return true;
+  InfoContent content = currentInfoContent();
+  return content.timeValid != shownInfoContent.timeValid || content.hour != shownInfoContent.hour ||
+         content.minute != shownInfoContent.minute || content.pm != shownInfoContent.pm ||
+         content.dataRevision != shownInfoContent.dataRevision;
 }
 
-void drawInfo() {
+static InfoContent renderInfo() {
   display.clearBuffer();
 
-  display.setFont(u8g2_font_fub20_tf);
+  InfoContent content = currentInfoContent();
 
   // Local time at top
-  String timeStr = getLocalTimeString();
-  bool hasMeridiem = false;
-  bool isPm = false;
-  if (timeStr.length() > 0) {
-    char suffix = timeStr.charAt(timeStr.length() - 1);
-    if (suffix == 'A' || suffix == 'P') {
-      hasMeridiem = true;
-      isPm = suffix == 'P';
-      timeStr.remove(timeStr.length() - 1);
-    }
+  char timeStr[12];
+  if (content.timeValid) {
+    snprintf(timeStr, sizeof(timeStr), "%d:%02d", content.hour, content.minute);
+  } else {
+    snprintf(timeStr, sizeof(timeStr), "--:--");
+  }
+  const bool hasMeridiem = content.timeValid;
+  const bool useAtlas = clockAtlasCovers(timeStr);
+  int timeW = 0;
+  if (useAtlas) {
+    timeW = clockTextWidth(timeStr);
+  } else {
+    display.setFont(u8g2_font_fub20_tf);
+    timeW = display.getStrWidth(timeStr);
   }
-  int timeW = display.getStrWidth(timeStr.c_str());
   const int meridiemIconW = 10;
   const int meridiemGap = 3;
   int totalTimeW = timeW + (hasMeridiem ? (meridiemGap + meridiemIconW) : 0);
   int timeX = (128 - totalTimeW) / 2;
   if (timeX < 0) timeX = 0;
-  display.drawStr(timeX, 24, timeStr.c_str());
+  if (useAtlas) {
+    blitClockText(timeX, timeStr);
+  } else {
+    display.drawStr(timeX, kClockBaselineY, timeStr);
+  }
   if (hasMeridiem) {
     int iconX = timeX + timeW + meridiemGap;
     int iconY = 10;
-    if (isPm) {
+    if (content.pm) {
       drawMoonIcon(iconX, iconY);
     } else {
       drawSunIcon(iconX, iconY);
@@ -330,17 +360,26 @@ void drawInfo() {
 
   // Temperature + weather icon centered below
   display.setFont(u8g2_font_fub14_tf);
-  String tempStr = infoTemperature;
-  int tempW = display.getStrWidth(tempStr.c_str());
+  const char* tempStr = infoTemperature.c_str();
+  int tempW = display.getStrWidth(tempStr);
   const int iconW = 16;
   const int gap = 4;
   int totalW = tempW + gap + iconW;
   int tempX = (128 - totalW) / 2;
   if (tempX < 0) tempX = 0;
-  display.drawStr(tempX, 54, tempStr.c_str());
+  display.drawStr(tempX, 54, tempStr);
   drawWeatherIcon(infoWeatherCode, tempX + tempW + gap, 39);
+  return content;
+}
 
-  display.sendBuffer();
+void renderInfoFrame() {
+  renderInfo();
+}
+
+void drawInfo() {
+  shownInfoContent = renderInfo();
+  infoContentShown = true;
+  flushDisplay();
 }
 
 void serviceBlink() {
@@ -349,10 +388,41 @@ void serviceBlink() {
   if (!blinkClosed && now >= nextBlinkMs) {
     blinkClosed = true;
     blinkUntilMs = now + 120;
+    invalidateDisplay();
   }
 
   if (blinkClosed && now >= blinkUntilMs) {
     blinkClosed = false;
     scheduleBlink(now);
+    invalidateDisplay();
+  }
+}
+
+void serviceDisplay() {
+  serviceDisplayPipeline();
+
+  // Nothing is rendered while the panel sleeps; displayDirty stays set so
+  // waking up redraws straight away.
+  if (powerDisplayOff()) return;
+
+  uint32_t now = millis();
+  if (!displayDirty && static_cast<int32_t>(now - nextFaceRefreshMs) < 0) return;
+
+  const bool forced = displayDirty;
+  displayDirty = false;
+  if (currentDisplayMode == DisplayMode::Info) {
+    // The Info screen only changes per minute or per weather update, so the
+    // 1 s tick is just a cheap comparison unless something moved.
+    nextFaceRefreshMs = now + kInfoDisplayRefreshMs;
+    if (forced || infoContentChanged()) {
+      drawInfo();
+    }
+  } else {
+    nextFaceRefreshMs = nextFaceChangeMs(now);
+    const uint32_t minInterval = powerMinFrameIntervalMs();
+    if (static_cast<int32_t>(nextFaceRefreshMs - (now + minInterval)) < 0) {
+      nextFaceRefreshMs = now + minInterval;
+    }
+    drawFace();
   }
 }
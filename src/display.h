@@ -4,6 +4,8 @@
 #include <Wire.h>
 #include "config.h"
 #include "types.h"
+#include "face.h"
+#include "display_pipeline.h"
 
 extern U8G2_SSD1306_128X64_NONAME_F_HW_I2C display;
 
@@ -11,12 +13,21 @@ extern uint32_t nextBlinkMs;
 extern uint32_t blinkUntilMs;
 extern uint32_t nextFaceRefreshMs;
 extern bool blinkClosed;
+extern bool displayDirty;
 
 static constexpr uint32_t kFaceRefreshMs = 33UL;
 static constexpr uint32_t kInfoDisplayRefreshMs = 1000UL;
 
 void drawFace();
+void initInfoClockAtlas();
+bool infoContentChanged();
+// Draws the Info screen into the buffer without sending it.
+void renderInfoFrame();
 void drawInfo();
+void invalidateDisplay();
+void restartSpeechMarquee();
+uint32_t nextFaceChangeMs(uint32_t now);
+void serviceDisplay();
 void scheduleBlink(uint32_t now);
 void serviceBlink();
 void drawWeatherIcon(int weatherCode, int x, int y);
@@ -0,0 +1,155 @@
+#include "display_pipeline.h"
+#include "display.h"
+#include "config.h"
+
+uint32_t displayFramesSent = 0;
+uint32_t displayFramesDropped = 0;
+uint32_t displayLastFrameBytes = 0;
+uint32_t displayBytesSentTotal = 0;
+
+// Two framebuffers: U8g2 renders into the back one while the transfer task
+// sends the front one. Only loop() swaps them, and only while the task is idle.
+static uint8_t secondFrame[kFrameBufferBytes];
+static uint8_t* frontFrame = nullptr;
+
+// Copy of what the panel currently shows, so only changed tiles go over I2C.
+// Owned by the transfer task.
+static uint8_t lastSentFrame[kFrameBufferBytes];
+static bool lastSentValid = false;
+
+static TaskHandle_t transferTask = nullptr;
+static volatile bool transferBusy = false;
+static bool framePending = false;
+static uint16_t pendingScrollSteps = 0;
+static uint16_t frontScrollSteps = 0;
+
+// Panel control requested by loop(), applied by the transfer task.
+static volatile bool panelStateDirty = false;
+static volatile uint8_t panelContrast = 0;
+static volatile bool panelPowerSave = false;
+
+static constexpr uint8_t kSpeechPage = kDisplayTileRows - 1;
+static bool speechTailStale = false;
+
+#if OLED_HW_SCROLL
+// Shifts the speech page one column left in panel RAM and mirrors that in
+// lastSentFrame, so the diff only finds the newly exposed right-hand tile.
+static void scrollSpeechPageLeft() {
+  if (!lastSentValid) return;
+
+  u8x8_t* u8x8 = display.getU8x8();
+  u8x8_cad_StartTransfer(u8x8);
+  u8x8_cad_SendCmd(u8x8, 0x2D);  // content scroll left by one column
+  u8x8_cad_SendArg(u8x8, 0x00);
+  u8x8_cad_SendArg(u8x8, kSpeechPage);  // start page
+  u8x8_cad_SendArg(u8x8, 0x01);
+  u8x8_cad_SendArg(u8x8, kSpeechPage);  // end page
+  u8x8_cad_SendArg(u8x8, 0x00);         // start column
+  u8x8_cad_SendArg(u8x8, kDisplayWidth - 1);
+  u8x8_cad_EndTransfer(u8x8);
+
+  uint8_t* page = lastSentFrame + static_cast<size_t>(kSpeechPage) * kDisplayWidth;
+  memmove(page, page + 1, kDisplayWidth - 1);
+  // Whatever the panel shifts into the last column is not trusted.
+  speechTailStale = true;
+}
+#endif
+
+static uint32_t sendChangedTiles(uint8_t* frame) {
+  u8x8_t* u8x8 = display.getU8x8();
+  uint32_t bytes = 0;
+
+  for (uint8_t row = 0; row < kDisplayTileRows; ++row) {
+    const size_t rowOffset = static_cast<size_t>(row) * kDisplayWidth;
+    int runStart = -1;
+    // One past the last column closes any run that reaches the right edge.
+    for (uint8_t col = 0; col <= kDisplayTileCols; ++col) {
+      bool dirty = false;
+      if (col < kDisplayTileCols) {
+        const size_t offset = rowOffset + static_cast<size_t>(col) * 8;
+        dirty = !lastSentValid || memcmp(frame + offset, lastSentFrame + offset, 8) != 0 ||
+                (speechTailStale && row == kSpeechPage && col == kDisplayTileCols - 1);
+      }
+      if (dirty && runStart < 0) {
+        runStart = col;
+      } else if (!dirty && runStart >= 0) {
+        uint8_t runW = static_cast<uint8_t>(col - runStart);
+        u8x8_DrawTile(u8x8, static_cast<uint8_t>(runStart), row, runW,
+                      frame + rowOffset + static_cast<size_t>(runStart) * 8);
+        bytes += runW * 8U;
+        runStart = -1;
+      }
+    }
+  }
+
+  memcpy(lastSentFrame, frame, kFrameBufferBytes);
+  lastSentValid = true;
+  speechTailStale = false;
+  return bytes;
+}
+
+static void displayTransferTask(void*) {
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (panelStateDirty) {
+      panelStateDirty = false;
+      // The panel keeps its RAM while asleep, so lastSentFrame stays valid.
+      u8x8_SetContrast(display.getU8x8(), panelContrast);
+      u8x8_SetPowerSave(display.getU8x8(), panelPowerSave ? 1 : 0);
+    }
+    if (!transferBusy) continue;
+#if OLED_HW_SCROLL
+    // Several accumulated steps are cheaper to resend than to scroll one by one.
+    if (frontScrollSteps == 1) {
+      scrollSpeechPageLeft();
+    }
+#endif
+    // The I2C driver blocks on its completion interrupt, so loop() keeps
+    // running (HTTP, reminders) while these tiles are on the wire.
+    uint32_t bytes = sendChangedTiles(frontFrame);
+    displayFramesSent++;
+    displayLastFrameBytes = bytes;
+    displayBytesSentTotal += bytes;
+    transferBusy = false;
+  }
+}
+
+void initDisplayPipeline() {
+  frontFrame = secondFrame;
+  // Priority above loopTask so a transfer starts as soon as it is queued; the
+  // task spends nearly all of its time blocked on the bus.
+  xTaskCreate(displayTransferTask, "oled_tx", 3072, nullptr, 2, &transferTask);
+}
+
+void flushDisplay(uint8_t speechScrollSteps) {
+  pendingScrollSteps = static_cast<uint16_t>(pendingScrollSteps + speechScrollSteps);
+  if (transferBusy) {
+    // Keep the newest frame in the back buffer; a frame already waiting there
+    // is overwritten by the next render and never reaches the panel.
+    if (framePending) displayFramesDropped++;
+    framePending = true;
+    return;
+  }
+
+  framePending = false;
+  uint8_t* rendered = display.getBufferPtr();
+  display.getU8g2()->tile_buf_ptr = frontFrame;
+  frontFrame = rendered;
+  frontScrollSteps = pendingScrollSteps;
+  pendingScrollSteps = 0;
+  transferBusy = true;
+  xTaskNotifyGive(transferTask);
+}
+
+void setPanelState(uint8_t contrast, bool powerSave) {
+  panelContrast = contrast;
+  panelPowerSave = powerSave;
+  panelStateDirty = true;
+  xTaskNotifyGive(transferTask);
+}
+
+void serviceDisplayPipeline() {
+  if (framePending && !transferBusy) {
+    flushDisplay();
+  }
+}
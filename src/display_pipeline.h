@@ -0,0 +1,26 @@
+#pragma once
+#include <Arduino.h>
+
+// SSD1306 framebuffer geometry: 8 pages of 128 one-byte columns, sent as 8x8 tiles.
+static constexpr uint8_t kDisplayWidth = 128;
+static constexpr uint8_t kDisplayTileCols = 16;
+static constexpr uint8_t kDisplayTileRows = 8;
+static constexpr size_t kFrameBufferBytes = 1024;
+
+// Transfer stats (payload bytes only, excluding I2C command overhead).
+extern uint32_t displayFramesSent;
+extern uint32_t displayFramesDropped;
+extern uint32_t displayLastFrameBytes;
+extern uint32_t displayBytesSentTotal;
+
+// Starts the background transfer task. Call once after display.begin().
+void initDisplayPipeline();
+// Hands the rendered back buffer to the transfer task and gives U8g2 a fresh one.
+// `speechScrollSteps` is how many columns the bottom page moved left since the
+// previous frame; a single step is done with the panel's scroll command.
+void flushDisplay(uint8_t speechScrollSteps = 0);
+// Queues a contrast / panel sleep change; the transfer task applies it between
+// frames so it never interleaves with tile data on the bus.
+void setPanelState(uint8_t contrast, bool powerSave);
+// Presents a frame that was held back while the bus was busy. Call from loop().
+void serviceDisplayPipeline();
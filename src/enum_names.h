@@ -0,0 +1,81 @@
+#pragma once
+#include <Arduino.h>
+#include <strings.h>
+#include "types.h"
+#include "perfect_hash.h"
+
+// Name tables for the enums that cross the API. Each table lists its values
+// in declaration order, so toString is an index; parsing is a case-insensitive
+// perfect-hash lookup. Neither allocates.
+
+template <typename E>
+struct EnumName {
+  const char* name;
+  E value;
+};
+
+template <typename E, size_t N>
+constexpr bool enumNamesInOrder(const EnumName<E> (&names)[N], size_t i = 0) {
+  return i == N ? true
+         : static_cast<size_t>(names[i].value) != i ? false
+         : enumNamesInOrder(names, i + 1);
+}
+
+static constexpr EnumName<Emotion> kEmotionNames[] = {
+    {"neutral", Emotion::Neutral},     {"happy", Emotion::Happy},
+    {"sad", Emotion::Sad},             {"sleepy", Emotion::Sleepy},
+    {"angry", Emotion::Angry},         {"surprised", Emotion::Surprised},
+    {"thinking", Emotion::Thinking},   {"love", Emotion::Love},
+};
+static_assert(sizeof(kEmotionNames) / sizeof(kEmotionNames[0]) == kEmotionCount,
+              "kEmotionNames must cover every Emotion");
+static_assert(enumNamesInOrder(kEmotionNames), "kEmotionNames must be in Emotion order");
+
+static constexpr EnumName<DisplayMode> kDisplayModeNames[] = {
+    {"face", DisplayMode::Face},
+    {"info", DisplayMode::Info},
+};
+static_assert(enumNamesInOrder(kDisplayModeNames), "kDisplayModeNames must be in DisplayMode order");
+
+struct EmotionNameKeys {
+  static constexpr size_t kCount = kEmotionCount;
+  static constexpr size_t kSlots = 16;
+  static constexpr uint32_t hash(size_t i, uint32_t seed) {
+    return perfect_hash::hashStringFolded(kEmotionNames[i].name, perfect_hash::start(seed));
+  }
+};
+
+struct DisplayModeNameKeys {
+  static constexpr size_t kCount = sizeof(kDisplayModeNames) / sizeof(kDisplayModeNames[0]);
+  static constexpr size_t kSlots = 4;
+  static constexpr uint32_t hash(size_t i, uint32_t seed) {
+    return perfect_hash::hashStringFolded(kDisplayModeNames[i].name, perfect_hash::start(seed));
+  }
+};
+
+template <typename Keys, typename E, size_t N>
+bool tryParseEnumName(const EnumName<E> (&names)[N], const char* name, E& outValue) {
+  if (name == nullptr) return false;
+  typedef PerfectHash<Keys> Hash;
+  size_t index = Hash::candidate(perfect_hash::hashStringFolded(name, perfect_hash::start(Hash::kSeed)));
+  if (index >= N || strcasecmp(name, names[index].name) != 0) return false;
+  outValue = names[index].value;
+  return true;
+}
+
+inline const char* emotionToString(Emotion emotion) {
+  size_t index = static_cast<size_t>(emotion);
+  return index < kEmotionCount ? kEmotionNames[index].name : kEmotionNames[0].name;
+}
+
+inline const char* displayModeToString(DisplayMode mode) {
+  return kDisplayModeNames[static_cast<size_t>(mode)].name;
+}
+
+inline bool tryParseEmotion(const char* name, Emotion& outEmotion) {
+  return tryParseEnumName<EmotionNameKeys>(kEmotionNames, name, outEmotion);
+}
+
+inline bool tryParseDisplayMode(const char* name, DisplayMode& outMode) {
+  return tryParseEnumName<DisplayModeNameKeys>(kDisplayModeNames, name, outMode);
+}
@@ -0,0 +1,141 @@
+#include <lwip/sockets.h>
+#include "events.h"
+#include "web_server.h"
+#include "enum_names.h"
+
+// State owned by main.cpp
+extern Emotion currentEmotion;
+extern DisplayMode currentDisplayMode;
+extern String speechText;
+
+uint32_t eventsPublished = 0;
+uint32_t eventSubscribersDropped = 0;
+
+// Each subscriber holds its own copy of the request's WiFiClient. WebServer
+// drops its reference once the handler returns, so ours keeps the socket open.
+struct EventSubscriber {
+  bool active;
+  WiFiClient client;
+};
+
+static EventSubscriber subscribers[kMaxEventSubscribers];
+static uint32_t lastKeepaliveMs = 0;
+
+// Event frames stay small; bigger payloads are dropped rather than split.
+static constexpr size_t kEventFrameBytes = 512;
+
+static void dropSubscriber(EventSubscriber& sub) {
+  sub.client.stop();
+  sub.client = WiFiClient();
+  sub.active = false;
+  eventSubscribersDropped++;
+}
+
+// WiFiClient::write() waits out a full send window for up to ~10 s, which a
+// peer that stays connected but stops reading would cost every publisher. So
+// frames go straight to the socket without waiting, and anything short of the
+// whole frame (EAGAIN included) drops the subscriber: a partial frame would
+// garble the stream anyway.
+static bool sendNow(const WiFiClient& client, const char* text, size_t len) {
+  int fd = client.fd();
+  if (fd < 0) return false;
+  ssize_t sent = send(fd, text, len, MSG_DONTWAIT);
+  return sent == static_cast<ssize_t>(len);
+}
+
+static void sendTo(EventSubscriber& sub, const char* text, size_t len) {
+  if (!sub.active) return;
+  if (!sub.client.connected() || !sendNow(sub.client, text, len)) {
+    dropSubscriber(sub);
+  }
+}
+
+static size_t formatEvent(char* frame, const char* type, JsonDocument& data) {
+  int head = snprintf(frame, kEventFrameBytes, "event: %s\ndata: ", type);
+  if (head <= 0) return 0;
+  size_t bodyLen = measureJson(data);
+  if (static_cast<size_t>(head) + bodyLen + 3 > kEventFrameBytes) {
+    Serial.print("Event too large, dropped: ");
+    Serial.println(type);
+    return 0;
+  }
+  size_t len = static_cast<size_t>(head) + serializeJson(data, frame + head, kEventFrameBytes - head);
+  frame[len++] = '\n';
+  frame[len++] = '\n';
+  return len;
+}
+
+bool hasEventSubscribers() {
+  return eventSubscriberCount() > 0;
+}
+
+size_t eventSubscriberCount() {
+  size_t count = 0;
+  for (size_t i = 0; i < kMaxEventSubscribers; ++i) {
+    if (subscribers[i].active) count++;
+  }
+  return count;
+}
+
+void publishEvent(const char* type, JsonDocument& data) {
+  if (!hasEventSubscribers()) return;
+  char frame[kEventFrameBytes];
+  size_t len = formatEvent(frame, type, data);
+  if (len == 0) return;
+  for (size_t i = 0; i < kMaxEventSubscribers; ++i) {
+    sendTo(subscribers[i], frame, len);
+  }
+  eventsPublished++;
+}
+
+void handleEvents() {
+  EventSubscriber* slot = nullptr;
+  for (size_t i = 0; i < kMaxEventSubscribers; ++i) {
+    if (subscribers[i].active && !subscribers[i].client.connected()) {
+      dropSubscriber(subscribers[i]);
+    }
+    if (!subscribers[i].active && slot == nullptr) slot = &subscribers[i];
+  }
+  if (slot == nullptr) {
+    JsonDocument error;
+    error["error"] = "Too many event subscribers";
+    sendJson(503, error);
+    return;
+  }
+
+  // Headers are written by hand: WebServer has no way to leave a response open.
+  static const char kHeaders[] =
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: text/event-stream\r\n"
+      "Cache-Control: no-cache\r\n"
+      "Connection: keep-alive\r\n"
+      "Access-Control-Allow-Origin: *\r\n"
+      "\r\n"
+      "retry: 2000\n\n";
+  slot->client = server.client();
+  slot->client.setNoDelay(true);
+  slot->active = true;
+  sendTo(*slot, kHeaders, sizeof(kHeaders) - 1);
+  if (!slot->active) return;
+
+  // Start every stream with a snapshot so clients need no separate /status call.
+  JsonDocument hello;
+  hello["emotion"] = emotionToString(currentEmotion);
+  hello["mode"] = displayModeToString(currentDisplayMode);
+  hello["speech"] = speechText;
+  char frame[kEventFrameBytes];
+  size_t len = formatEvent(frame, "hello", hello);
+  if (len > 0) sendTo(*slot, frame, len);
+}
+
+void serviceEvents() {
+  uint32_t now = millis();
+  if (now - lastKeepaliveMs < kEventKeepaliveMs) return;
+  lastKeepaliveMs = now;
+
+  // SSE comment line: keeps proxies and NAT from timing out, and finds dead peers.
+  static const char kKeepalive[] = ":\n\n";
+  for (size_t i = 0; i < kMaxEventSubscribers; ++i) {
+    sendTo(subscribers[i], kKeepalive, sizeof(kKeepalive) - 1);
+  }
+}
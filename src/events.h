@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Server-Sent Events on GET /events. Each state change is pushed as
+//   event: <type>
+//   data: <small JSON object>
+// Types: hello, emotion, speech, mode, notes, reminders, reminder_fired, weather.
+
+static constexpr size_t kMaxEventSubscribers = 3;
+static constexpr uint32_t kEventKeepaliveMs = 15000UL;
+
+extern uint32_t eventsPublished;
+extern uint32_t eventSubscribersDropped;
+
+void handleEvents();
+// Sends an event to every subscriber; a no-op when nobody is listening.
+void publishEvent(const char* type, JsonDocument& data);
+bool hasEventSubscribers();
+size_t eventSubscriberCount();
+// Keepalive comments and dead-connection cleanup. Call from loop().
+void serviceEvents();
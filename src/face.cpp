@@ -0,0 +1,333 @@
+#include "face.h"
+#include "display.h"
+#include "raster.h"
+
+// State owned by main.cpp
+extern Emotion currentEmotion;
+
+static bool transitionActive = false;
+static uint32_t transitionStartMs = 0;
+static FaceParams transitionFrom;
+
+static bool gazeActive = false;
+static int8_t gazeX = 0;
+static int8_t gazeY = 0;
+static uint32_t gazeSetMs = 0;
+
+void drawEyes(int y, int h, int curve, bool closed) {
+  uint8_t* frame = display.getBufferPtr();
+  const int leftX = 30;
+  const int rightX = 78;
+  const int eyeW = 20;
+
+  if (closed) {
+    rasterHLine(frame, leftX, y + h / 2, eyeW);
+    rasterHLine(frame, rightX, y + h / 2, eyeW);
+    return;
+  }
+
+  rasterRBox(frame, leftX, y, eyeW, h, curve);
+  rasterRBox(frame, rightX, y, eyeW, h, curve);
+}
+
+void drawPupils(int y, int h, int offsetX, int offsetY) {
+  if (h < 8) return;
+  uint8_t* frame = display.getBufferPtr();
+  const int leftCenterX = 40 + offsetX;
+  const int rightCenterX = 88 + offsetX;
+  // Keep the pupil inside the eye however narrow it is.
+  const int maxOffsetY = h / 2 - 3;
+  const int centerY = y + h / 2 + constrain(offsetY, -maxOffsetY, maxOffsetY);
+  rasterDisc(frame, leftCenterX, centerY, 2);
+  rasterDisc(frame, rightCenterX, centerY, 2);
+  // Tiny glint makes eyes look less flat.
+  rasterPixel(frame, leftCenterX - 1, centerY - 1);
+  rasterPixel(frame, rightCenterX - 1, centerY - 1);
+}
+
+void drawBrows(int leftX1, int leftY1, int leftX2, int leftY2, int rightX1, int rightY1, int rightX2,
+               int rightY2) {
+  uint8_t* frame = display.getBufferPtr();
+  rasterLine(frame, leftX1, leftY1, leftX2, leftY2);
+  rasterLine(frame, rightX1, rightY1, rightX2, rightY2);
+}
+
+void drawMouthFlat(int y, int w) {
+  uint8_t* frame = display.getBufferPtr();
+  int x = (128 - w) / 2;
+  rasterHLine(frame, x, y, w);
+}
+
+void drawMouthSmile(int y, int w) {
+  uint8_t* frame = display.getBufferPtr();
+  int x = (128 - w) / 2;
+  rasterLine(frame, x, y, x + w / 2, y + 3);
+  rasterLine(frame, x + w / 2, y + 3, x + w, y);
+  rasterPixel(frame, x + 1, y + 1);
+  rasterPixel(frame, x + w - 1, y + 1);
+}
+
+void drawMouthFrown(int y, int w) {
+  uint8_t* frame = display.getBufferPtr();
+  int x = (128 - w) / 2;
+  rasterLine(frame, x, y + 3, x + w / 2, y);
+  rasterLine(frame, x + w / 2, y, x + w, y + 3);
+  rasterPixel(frame, x + 1, y + 2);
+  rasterPixel(frame, x + w - 1, y + 2);
+}
+
+void drawMouthOpen(int cx, int cy, int r) {
+  uint8_t* frame = display.getBufferPtr();
+  rasterCircle(frame, cx, cy, r);
+  if (r >= 5) {
+    rasterCircle(frame, cx, cy, r - 1);
+  }
+}
+
+void drawCheeks() {
+  uint8_t* frame = display.getBufferPtr();
+  rasterDisc(frame, 22, 42, 1);
+  rasterDisc(frame, 26, 44, 1);
+  rasterDisc(frame, 106, 42, 1);
+  rasterDisc(frame, 102, 44, 1);
+}
+
+void drawThoughtBubble(int wobble) {
+  uint8_t* frame = display.getBufferPtr();
+  int baseY = 49 - wobble;
+  rasterDisc(frame, 54, baseY - 5, 1);
+  rasterDisc(frame, 61, baseY - 3, 2);
+  rasterDisc(frame, 71, baseY, 3);
+  rasterCircle(frame, 82, baseY + 2, 5);
+  rasterCircle(frame, 89, baseY + 1, 4);
+  rasterCircle(frame, 94, baseY + 3, 3);
+}
+
+void drawSleepZ(int phase) {
+  int y = 10 + phase;
+  display.setFont(u8g2_font_5x8_tr);
+  display.drawStr(95, y, "Z");
+  display.drawStr(104, y + 4, "z");
+  display.drawStr(111, y + 8, "z");
+}
+
+void drawHeart(int cx, int cy, int r) {
+  uint8_t* frame = display.getBufferPtr();
+  rasterDisc(frame, cx - r / 2, cy - r / 2, r / 2 + 1);
+  rasterDisc(frame, cx + r / 2, cy - r / 2, r / 2 + 1);
+  // Triangles are rare enough to leave on U8g2's scanline fill.
+  display.drawTriangle(cx - r - 1, cy - r / 3, cx + r + 1, cy - r / 3, cx, cy + r + 1);
+}
+
+static const EmotionDef& emotionDef(Emotion emotion) {
+  size_t index = static_cast<size_t>(emotion);
+  return kEmotionDefs[index < kEmotionCount ? index : 0];
+}
+
+FaceFrameKey normalizeFaceKey(FaceFrameKey key) {
+  const EmotionDef& def = emotionDef(key.emotion);
+  if (def.eyesShut) key.closed = true;
+
+  // Zero the clocks this emotion ignores so identical frames share one cache slot.
+  uint8_t waves = key.closed ? closedWaveMask(def) : openWaveMask(def);
+  if ((waves & (1U << kWaveGlance)) == 0) key.glance = 0;
+  if ((waves & (1U << kWavePulse2)) == 0) key.pulse2 = 0;
+  if ((waves & (1U << kWavePulse3)) == 0) key.pulse3 = 0;
+  if ((waves & (1U << kWaveBob)) == 0) key.bobY = 0;
+  // Gaze only moves visible pupils.
+  if (key.closed || (def.extras & kExtraHeartEyes) != 0) {
+    key.gazeX = 0;
+    key.gazeY = 0;
+  }
+  return key;
+}
+
+FaceFrameKey rawFaceKey(uint32_t now) {
+  const EmotionDef& def = emotionDef(currentEmotion);
+  FaceFrameKey key;
+  key.emotion = currentEmotion;
+  key.closed = blinkClosed || def.eyesShut;
+  int bob = static_cast<int>((now / 300UL) % 4UL);              // 0..3
+  key.glance = static_cast<int8_t>((now / 400UL) % 3UL) - 1;    // -1, 0, 1 subtle scanning look
+  key.pulse2 = static_cast<int8_t>((now / 220UL) % 2UL);        // 0/1
+  key.pulse3 = static_cast<int8_t>((now / 260UL) % 3UL) - 1;    // -1/0/1
+  key.bobY = static_cast<int8_t>((bob < 2) ? bob : (3 - bob));  // 0,1,1,0
+  key.gazeX = 0;
+  key.gazeY = 0;
+  if (untilGazeReleaseMs(now) != UINT32_MAX) {
+    // A held gaze replaces the idle scanning look.
+    key.glance = 0;
+    key.gazeX = gazeX;
+    key.gazeY = gazeY;
+  }
+  return key;
+}
+
+FaceFrameKey currentFaceKey(uint32_t now) {
+  return normalizeFaceKey(rawFaceKey(now));
+}
+
+static int16_t resolveAnim(const AnimValue& value, const FaceFrameKey& key) {
+  int wave = 0;
+  switch (value.wave) {
+    case kWavePulse2:
+      wave = key.pulse2;
+      break;
+    case kWavePulse3:
+      wave = key.pulse3;
+      break;
+    case kWaveBob:
+      wave = key.bobY;
+      break;
+    case kWaveGlance:
+      wave = key.glance;
+      break;
+    default:
+      break;
+  }
+  return static_cast<int16_t>(value.base + value.gain * wave);
+}
+
+FaceParams resolveFaceParams(const FaceFrameKey& key) {
+  const EmotionDef& def = emotionDef(key.emotion);
+  FaceParams params;
+  params.eyeY = resolveAnim(def.eyeY, key);
+  params.eyeH = resolveAnim(def.eyeH, key);
+  params.eyeCurve = def.eyeCurve;
+  params.pupilX = static_cast<int16_t>(resolveAnim(def.pupilX, key) + key.gazeX);
+  params.pupilY = key.gazeY;
+  for (size_t i = 0; i < 8; ++i) {
+    params.brows[i] = resolveAnim(def.brows[i], key);
+  }
+  params.mouth = def.mouth;
+  params.mouthY = resolveAnim(def.mouthY, key);
+  params.mouthSize = resolveAnim(def.mouthSize, key);
+  params.extras = def.extras;
+  params.closed = key.closed;
+  params.heartEyes = (def.extras & kExtraHeartEyes) != 0;
+  return params;
+}
+
+void renderFaceParams(const FaceParams& p, const FaceFrameKey& key) {
+  uint8_t* frame = display.getBufferPtr();
+  const int pulse2 = key.pulse2;
+
+  if (p.heartEyes && !p.closed) {
+    int heartPulse = 5 + pulse2;
+    drawHeart(40, 24 + key.bobY, heartPulse);
+    drawHeart(88, 24 + key.bobY, heartPulse);
+  } else {
+    drawEyes(p.eyeY, p.eyeH, p.eyeCurve, p.closed);
+    if (!p.closed) {
+      drawPupils(p.eyeY, p.eyeH, p.pupilX, p.pupilY);
+    }
+  }
+
+  drawBrows(p.brows[0], p.brows[1], p.brows[2], p.brows[3], p.brows[4], p.brows[5], p.brows[6],
+            p.brows[7]);
+
+  switch (p.mouth) {
+    case MouthType::Smile:
+      drawMouthSmile(p.mouthY, p.mouthSize);
+      break;
+    case MouthType::Frown:
+      drawMouthFrown(p.mouthY, p.mouthSize);
+      break;
+    case MouthType::Open:
+      drawMouthOpen(64, p.mouthY, p.mouthSize);
+      break;
+    case MouthType::Flat:
+    default:
+      drawMouthFlat(p.mouthY, p.mouthSize);
+      break;
+  }
+
+  if (p.extras & kExtraCheeks) {
+    drawCheeks();
+  }
+  if (p.extras & kExtraTears) {
+    rasterPixel(frame, 25, 36 + (pulse2 * 2));
+    rasterPixel(frame, 103, 36 + ((1 - pulse2) * 2));
+  }
+  if (p.extras & kExtraTeeth) {
+    rasterLine(frame, 52, 47 + pulse2, 76, 47 + pulse2);
+    rasterLine(frame, 52, 48 + pulse2, 76, 48 + pulse2);
+  }
+  if (p.extras & kExtraDrool) {
+    rasterPixel(frame, 63 + pulse2, 50);
+  }
+  if (p.extras & kExtraSleepZ) {
+    drawSleepZ(pulse2);
+  }
+  if (p.extras & kExtraThought) {
+    drawThoughtBubble(pulse2);
+  }
+}
+
+void renderFaceFeatures(const FaceFrameKey& key) {
+  renderFaceParams(resolveFaceParams(key), key);
+}
+
+// Q8 fixed-point blend; t runs 0..256.
+static int16_t blend(int16_t from, int16_t to, int32_t t) {
+  return static_cast<int16_t>(from + (((to - from) * t + 128) >> 8));
+}
+
+static FaceParams blendFaceParams(const FaceParams& from, const FaceParams& to, int32_t t) {
+  // Shapes and decorations cannot be blended, so they switch at the halfway point.
+  FaceParams out = t < 128 ? from : to;
+  out.eyeY = blend(from.eyeY, to.eyeY, t);
+  out.eyeH = blend(from.eyeH, to.eyeH, t);
+  out.eyeCurve = blend(from.eyeCurve, to.eyeCurve, t);
+  out.pupilX = blend(from.pupilX, to.pupilX, t);
+  out.pupilY = blend(from.pupilY, to.pupilY, t);
+  for (size_t i = 0; i < 8; ++i) {
+    out.brows[i] = blend(from.brows[i], to.brows[i], t);
+  }
+  out.mouthY = blend(from.mouthY, to.mouthY, t);
+  out.mouthSize = blend(from.mouthSize, to.mouthSize, t);
+  // Blinks are live, not part of either endpoint.
+  out.closed = to.closed;
+  return out;
+}
+
+void setGaze(int8_t x, int8_t y, uint32_t now) {
+  gazeX = static_cast<int8_t>(constrain(x, -kMaxGazeX, kMaxGazeX));
+  gazeY = static_cast<int8_t>(constrain(y, -kMaxGazeY, kMaxGazeY));
+  gazeSetMs = now;
+  gazeActive = true;
+}
+
+void releaseGaze() {
+  gazeActive = false;
+}
+
+uint32_t untilGazeReleaseMs(uint32_t now) {
+  if (!gazeActive) return UINT32_MAX;
+  uint32_t held = now - gazeSetMs;
+  // Checked against `now` rather than cleared, so lookahead in nextFaceChangeMs stays pure.
+  return held < kGazeHoldMs ? kGazeHoldMs - held : UINT32_MAX;
+}
+
+void beginFaceTransition(uint32_t now) {
+  transitionFrom = faceParamsAt(now);
+  transitionStartMs = now;
+  transitionActive = true;
+}
+
+bool faceTransitionActive(uint32_t now) {
+  if (transitionActive && now - transitionStartMs >= kFaceTransitionFrames * kFaceRefreshMs) {
+    transitionActive = false;
+  }
+  return transitionActive;
+}
+
+FaceParams faceParamsAt(uint32_t now) {
+  FaceParams target = resolveFaceParams(currentFaceKey(now));
+  if (!faceTransitionActive(now)) return target;
+
+  // Quantize to whole frames so every redraw in the transition is a distinct step.
+  uint32_t frame = (now - transitionStartMs) / kFaceRefreshMs + 1;
+  int32_t t = static_cast<int32_t>(frame * 256UL / kFaceTransitionFrames);
+  return blendFaceParams(transitionFrom, target, t);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <Arduino.h>
+#include "face_cache.h"
+#include "face_defs.h"
+
+// A face with every animation clock resolved to plain coordinates.
+struct FaceParams {
+  int16_t eyeY;
+  int16_t eyeH;
+  int16_t eyeCurve;
+  int16_t pupilX;
+  int16_t pupilY;  // offset from the eye centre
+  int16_t brows[8];
+  int16_t mouthY;
+  int16_t mouthSize;
+  MouthType mouth;
+  uint8_t extras;
+  bool closed;
+  bool heartEyes;
+};
+
+// Number of kFaceRefreshMs frames an emotion change is tweened over.
+static constexpr uint8_t kFaceTransitionFrames = 6;
+
+FaceFrameKey currentFaceKey(uint32_t now);
+// currentFaceKey() before normalizeFaceKey(): every clock still runs. Tween
+// frames draw with it, since their decorations may belong to either emotion.
+FaceFrameKey rawFaceKey(uint32_t now);
+// Forces derived fields and zeroes clocks the emotion does not use.
+FaceFrameKey normalizeFaceKey(FaceFrameKey key);
+FaceParams resolveFaceParams(const FaceFrameKey& key);
+void renderFaceParams(const FaceParams& params, const FaceFrameKey& key);
+void renderFaceFeatures(const FaceFrameKey& key);
+
+// Points the pupils at a fixed offset (clamped to kMaxGazeX/Y) instead of the
+// idle glance. The override lapses kGazeHoldMs after the last call.
+static constexpr uint32_t kGazeHoldMs = 1500;
+void setGaze(int8_t x, int8_t y, uint32_t now);
+void releaseGaze();
+// Milliseconds until an active gaze override lapses, or UINT32_MAX.
+uint32_t untilGazeReleaseMs(uint32_t now);
+
+// Snapshot the face as shown right now; call before currentEmotion changes.
+void beginFaceTransition(uint32_t now);
+bool faceTransitionActive(uint32_t now);
+// The face at `now`, blended toward the current emotion while a transition runs.
+FaceParams faceParamsAt(uint32_t now);
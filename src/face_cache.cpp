@@ -0,0 +1,63 @@
+#include "face_cache.h"
+#include "display.h"
+
+static constexpr size_t kFaceCacheEntries = FACE_FRAME_CACHE_BYTES / kFrameBufferBytes;
+
+uint32_t faceCacheHits = 0;
+uint32_t faceCacheMisses = 0;
+
+struct FaceCacheEntry {
+  bool valid;
+  uint32_t packedKey;
+  uint32_t lastUsed;
+  uint8_t frame[kFrameBufferBytes];
+};
+
+static FaceCacheEntry cacheEntries[kFaceCacheEntries > 0 ? kFaceCacheEntries : 1];
+static uint32_t cacheClock = 0;
+
+static uint32_t packKey(const FaceFrameKey& key) {
+  return (static_cast<uint32_t>(key.emotion) << 16) |
+         (static_cast<uint32_t>(key.gazeY + kMaxGazeY) << 12) |
+         (static_cast<uint32_t>(key.gazeX + kMaxGazeX) << 8) |
+         ((key.closed ? 1U : 0U) << 7) |
+         (static_cast<uint32_t>(key.glance + 1) << 5) |
+         (static_cast<uint32_t>(key.pulse2) << 4) |
+         (static_cast<uint32_t>(key.pulse3 + 1) << 2) |
+         static_cast<uint32_t>(key.bobY);
+}
+
+bool faceCacheLoad(const FaceFrameKey& key, uint8_t* frame) {
+  uint32_t packed = packKey(key);
+  for (size_t i = 0; i < kFaceCacheEntries; ++i) {
+    FaceCacheEntry& entry = cacheEntries[i];
+    if (!entry.valid || entry.packedKey != packed) continue;
+    entry.lastUsed = ++cacheClock;
+    memcpy(frame, entry.frame, kFrameBufferBytes);
+    faceCacheHits++;
+    return true;
+  }
+  faceCacheMisses++;
+  return false;
+}
+
+void faceCacheStore(const FaceFrameKey& key, const uint8_t* frame) {
+  if (kFaceCacheEntries == 0) return;
+
+  size_t victim = 0;
+  for (size_t i = 0; i < kFaceCacheEntries; ++i) {
+    if (!cacheEntries[i].valid) {
+      victim = i;
+      break;
+    }
+    if (cacheEntries[i].lastUsed < cacheEntries[victim].lastUsed) {
+      victim = i;
+    }
+  }
+
+  FaceCacheEntry& entry = cacheEntries[victim];
+  entry.valid = true;
+  entry.packedKey = packKey(key);
+  entry.lastUsed = ++cacheClock;
+  memcpy(entry.frame, frame, kFrameBufferBytes);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "types.h"
+
+// Everything that determines the face pixels (speech line excluded).
+struct FaceFrameKey {
+  Emotion emotion;
+  bool closed;
+  int8_t glance;  // -1..1
+  int8_t pulse2;  // 0..1
+  int8_t pulse3;  // -1..1
+  int8_t bobY;    // 0..1
+  int8_t gazeX;   // -kMaxGazeX..kMaxGazeX, 0 unless a gaze override is active
+  int8_t gazeY;   // -kMaxGazeY..kMaxGazeY
+};
+
+static constexpr int8_t kMaxGazeX = 7;
+static constexpr int8_t kMaxGazeY = 3;
+
+inline bool faceKeysEqual(const FaceFrameKey& a, const FaceFrameKey& b) {
+  return a.emotion == b.emotion && a.closed == b.closed && a.glance == b.glance &&
+         a.pulse2 == b.pulse2 && a.pulse3 == b.pulse3 && a.bobY == b.bobY &&
+         a.gazeX == b.gazeX && a.gazeY == b.gazeY;
+}
+
+extern uint32_t faceCacheHits;
+extern uint32_t faceCacheMisses;
+
+// Copies a cached frame into `frame` and returns true on a hit.
+bool faceCacheLoad(const FaceFrameKey& key, uint8_t* frame);
+// Stores `frame` under `key`, evicting the least recently used entry when full.
+void faceCacheStore(const FaceFrameKey& key, const uint8_t* frame);
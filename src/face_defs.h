@@ -0,0 +1,105 @@
+#pragma once
+#include <Arduino.h>
+#include "types.h"
+
+// Compile-time description of every emotion. Each coordinate is a base value
+// plus an optional gain on one of the animation clocks sampled in currentFaceKey().
+
+enum FaceWave : uint8_t { kWaveNone, kWavePulse2, kWavePulse3, kWaveBob, kWaveGlance };
+
+struct AnimValue {
+  int8_t base;
+  int8_t gain;
+  uint8_t wave;
+};
+
+constexpr AnimValue at(int8_t base) { return AnimValue{base, 0, kWaveNone}; }
+constexpr AnimValue onPulse2(int8_t base, int8_t gain = 1) { return AnimValue{base, gain, kWavePulse2}; }
+constexpr AnimValue onPulse3(int8_t base, int8_t gain = 1) { return AnimValue{base, gain, kWavePulse3}; }
+constexpr AnimValue onBob(int8_t base, int8_t gain = 1) { return AnimValue{base, gain, kWaveBob}; }
+constexpr AnimValue onGlance(int8_t base, int8_t gain = 1) { return AnimValue{base, gain, kWaveGlance}; }
+
+enum class MouthType : uint8_t { Flat, Smile, Frown, Open };
+
+// Decorations drawn on top of the eyes/brows/mouth. All of them animate on pulse2.
+enum FaceExtra : uint8_t {
+  kExtraCheeks = 1 << 0,
+  kExtraTears = 1 << 1,
+  kExtraSleepZ = 1 << 2,
+  kExtraDrool = 1 << 3,
+  kExtraTeeth = 1 << 4,
+  kExtraThought = 1 << 5,
+  kExtraHeartEyes = 1 << 6,  // open eyes are hearts (also bob with the face)
+};
+
+struct EmotionDef {
+  Emotion emotion;
+  bool eyesShut;
+  AnimValue eyeY;
+  AnimValue eyeH;
+  int8_t eyeCurve;
+  AnimValue pupilX;
+  AnimValue brows[8];  // left x1,y1,x2,y2 then right x1,y1,x2,y2
+  MouthType mouth;
+  AnimValue mouthY;     // centre y for Open
+  AnimValue mouthSize;  // width, or radius for Open
+  uint8_t extras;
+};
+
+static constexpr EmotionDef kEmotionDefs[] = {
+    {Emotion::Neutral, false, onBob(17), at(12), 5, onPulse3(0),
+     {at(30), at(12), at(48), onBob(12), at(78), at(12), at(96), onBob(12)},
+     MouthType::Flat, onBob(44), at(18), 0},
+    {Emotion::Happy, false, onBob(15), at(15), 5, onGlance(0),
+     {at(30), onBob(12), at(48), onBob(10), at(78), onBob(10), at(96), onBob(12)},
+     MouthType::Smile, onPulse2(41), at(26), kExtraCheeks},
+    {Emotion::Sad, false, onPulse2(18), at(10), 4, at(0),
+     {at(28), onPulse2(11), at(48), onPulse2(16), at(80), onPulse2(16), at(100), onPulse2(11)},
+     MouthType::Frown, onPulse2(43), at(24), kExtraTears},
+    {Emotion::Sleepy, true, onPulse2(24), at(4), 2, at(0),
+     {at(30), onPulse2(20), at(50), onPulse2(20), at(78), onPulse2(20), at(98), onPulse2(20)},
+     MouthType::Flat, onPulse2(46), at(14), kExtraSleepZ | kExtraDrool},
+    {Emotion::Angry, false, at(18), onPulse2(12), 2, onPulse3(0),
+     {at(25), onPulse2(14, -1), at(49), onPulse2(9, -1), at(103), onPulse2(14, -1), at(79),
+      onPulse2(9, -1)},
+     MouthType::Flat, at(44), onPulse2(22), kExtraTeeth},
+    {Emotion::Surprised, false, at(14), onPulse2(18), 9, at(0),
+     {at(30), onPulse2(10, -1), at(48), onPulse2(9, -1), at(78), onPulse2(9, -1), at(96),
+      onPulse2(10, -1)},
+     MouthType::Open, at(45), onPulse2(5), 0},
+    {Emotion::Thinking, false, at(17), at(11), 4, onPulse2(-1),
+     {at(29), at(12), at(47), onPulse2(11), at(78), at(12), at(97), onPulse2(14)},
+     MouthType::Flat, at(44), at(14), kExtraThought},
+    {Emotion::Love, false, at(18), at(10), 3, at(0),
+     {at(30), onBob(12), at(48), onBob(11), at(78), onBob(11), at(96), onBob(12)},
+     MouthType::Smile, onPulse2(41), at(28), kExtraCheeks | kExtraHeartEyes},
+};
+
+static_assert(sizeof(kEmotionDefs) / sizeof(kEmotionDefs[0]) == kEmotionCount,
+              "kEmotionDefs needs one entry per Emotion");
+
+constexpr bool emotionDefsOrdered(size_t i) {
+  return i >= kEmotionCount ||
+         (kEmotionDefs[i].emotion == static_cast<Emotion>(i) && emotionDefsOrdered(i + 1));
+}
+static_assert(emotionDefsOrdered(0), "kEmotionDefs must follow the Emotion enum order");
+
+// Which animation clocks can change an emotion's pixels, as bits of (1 << FaceWave).
+// Frames that only differ in unused clocks share a cache entry and a redraw slot.
+constexpr uint8_t waveBit(const AnimValue& v) {
+  return v.gain == 0 ? 0 : static_cast<uint8_t>(1U << v.wave);
+}
+
+constexpr uint8_t closedWaveMask(const EmotionDef& d) {
+  return static_cast<uint8_t>(
+      waveBit(d.eyeY) | waveBit(d.eyeH) | waveBit(d.brows[0]) | waveBit(d.brows[1]) |
+      waveBit(d.brows[2]) | waveBit(d.brows[3]) | waveBit(d.brows[4]) | waveBit(d.brows[5]) |
+      waveBit(d.brows[6]) | waveBit(d.brows[7]) | waveBit(d.mouthY) | waveBit(d.mouthSize) |
+      ((d.extras & ~(kExtraCheeks | kExtraHeartEyes)) != 0 ? (1U << kWavePulse2) : 0U));
+}
+
+constexpr uint8_t openWaveMask(const EmotionDef& d) {
+  return static_cast<uint8_t>(
+      closedWaveMask(d) | waveBit(d.pupilX) |
+      ((d.extras & kExtraHeartEyes) != 0 ? ((1U << kWavePulse2) | (1U << kWaveBob)) : 0U));
+}
@@ -0,0 +1,135 @@
+#include "json_bench.h"
+#ifdef JSON_BENCH
+
+static constexpr int kJsonBenchIterations = 32;
+
+// Counts every allocation ArduinoJson makes for the document path.
+class CountingAllocator : public ArduinoJson::Allocator {
+ public:
+  void* allocate(size_t size) override {
+    allocations++;
+    return malloc(size);
+  }
+  void deallocate(void* ptr) override { free(ptr); }
+  void* reallocate(void* ptr, size_t size) override {
+    allocations++;
+    return realloc(ptr, size);
+  }
+
+  uint32_t allocations = 0;
+};
+
+// Stands in for the socket: counts bytes and, when asked, tracks the lowest
+// free heap seen while the body is being produced.
+class CountingPrint : public Print {
+ public:
+  explicit CountingPrint(bool trackHeap) : sampleHeap(trackHeap) {}
+
+  size_t write(uint8_t) override {
+    sample();
+    bytes++;
+    return 1;
+  }
+  size_t write(const uint8_t*, size_t len) override {
+    sample();
+    bytes += len;
+    return len;
+  }
+  using Print::write;
+
+  size_t bytes = 0;
+  uint32_t minFreeHeap = UINT32_MAX;
+
+ private:
+  void sample() {
+    if (!sampleHeap) return;
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < minFreeHeap) minFreeHeap = freeHeap;
+  }
+
+  bool sampleHeap;
+};
+
+struct JsonBenchResult {
+  uint32_t totalUs = 0;
+  uint32_t maxUs = 0;
+  size_t bytes = 0;
+  uint32_t peakHeapBytes = 0;
+  uint32_t allocations = 0;
+};
+
+static void noteTime(JsonBenchResult& result, uint32_t elapsedUs) {
+  result.totalUs += elapsedUs;
+  if (elapsedUs > result.maxUs) result.maxUs = elapsedUs;
+}
+
+static void benchDocument(JsonBenchResult& result, void (*document)(JsonDocumentWriter&)) {
+  for (int i = 0; i < kJsonBenchIterations; ++i) {
+    const uint32_t freeBefore = ESP.getFreeHeap();
+    const uint32_t started = micros();
+    CountingAllocator allocator;
+    JsonDocument doc(&allocator);
+    JsonDocumentWriter writer(doc);
+    writer.beginObject();
+    document(writer);
+    writer.endObject();
+    String payload;
+    serializeJson(doc, payload);
+    noteTime(result, micros() - started);
+
+    // Document and output string are both alive here, as in sendJson().
+    const uint32_t used = freeBefore - ESP.getFreeHeap();
+    if (used > result.peakHeapBytes) result.peakHeapBytes = used;
+    result.bytes = payload.length();
+    result.allocations = allocator.allocations;
+  }
+}
+
+static void benchStreaming(JsonBenchResult& result, void (*streaming)(JsonWriter&)) {
+  for (int i = 0; i < kJsonBenchIterations; ++i) {
+    const uint32_t started = micros();
+    CountingPrint sink(false);
+    JsonWriter writer(sink);
+    writer.beginObject();
+    streaming(writer);
+    writer.endObject();
+    noteTime(result, micros() - started);
+    result.bytes = sink.bytes;
+  }
+
+  // Separate pass so heap sampling does not skew the timings above.
+  const uint32_t freeBefore = ESP.getFreeHeap();
+  CountingPrint sink(true);
+  JsonWriter writer(sink);
+  writer.beginObject();
+  streaming(writer);
+  writer.endObject();
+  result.peakHeapBytes = sink.minFreeHeap < freeBefore ? freeBefore - sink.minFreeHeap : 0;
+}
+
+static void reportResult(JsonObject out, const JsonBenchResult& result) {
+  out["avg_us"] = result.totalUs / kJsonBenchIterations;
+  out["max_us"] = result.maxUs;
+  out["bytes"] = result.bytes;
+  out["peak_heap_bytes"] = result.peakHeapBytes;
+}
+
+void runJsonBench(JsonDocument& out, const JsonBenchCase* cases, size_t count) {
+  out["iterations"] = kJsonBenchIterations;
+  JsonArray results = out["cases"].to<JsonArray>();
+  for (size_t i = 0; i < count; ++i) {
+    JsonBenchResult documentResult;
+    JsonBenchResult streamingResult;
+    benchDocument(documentResult, cases[i].document);
+    benchStreaming(streamingResult, cases[i].streaming);
+
+    JsonObject item = results.add<JsonObject>();
+    item["name"] = cases[i].name;
+    JsonObject doc = item["document"].to<JsonObject>();
+    reportResult(doc, documentResult);
+    doc["allocations"] = documentResult.allocations;
+    reportResult(item["streaming"].to<JsonObject>(), streamingResult);
+    item["same_size"] = documentResult.bytes == streamingResult.bytes;
+  }
+}
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#ifdef JSON_BENCH
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "json_writer.h"
+
+// On-device comparison of the streamed JSON responses with the old sendJson()
+// path. Only built with -DJSON_BENCH (see README, "JSON benchmark"); it blocks
+// the loop for the whole run, so it is not part of normal firmware.
+
+// One response body, emitted through either writer by the same template.
+struct JsonBenchCase {
+  const char* name;
+  void (*streaming)(JsonWriter&);
+  void (*document)(JsonDocumentWriter&);
+};
+
+// Produces each body both ways -- JsonDocument + serializeJson into a String,
+// as sendJson() does, and JsonWriter streaming into a byte counter -- and
+// reports latency, output size and heap use per case. Nothing is sent.
+void runJsonBench(JsonDocument& out, const JsonBenchCase* cases, size_t count);
+#endif
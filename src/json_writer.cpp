@@ -0,0 +1,152 @@
+#include "json_writer.h"
+#include <math.h>
+
+void JsonWriter::beforeValue() {
+  if (afterKey) {
+    afterKey = false;
+    return;
+  }
+  if (depth == 0) return;
+  const uint16_t bit = static_cast<uint16_t>(1U << (depth - 1));
+  if (hasElements & bit) out.write(',');
+  hasElements |= bit;
+}
+
+void JsonWriter::push() {
+  if (depth >= kMaxDepth) return;
+  depth++;
+  hasElements &= static_cast<uint16_t>(~(1U << (depth - 1)));
+}
+
+void JsonWriter::beginObject() {
+  beforeValue();
+  out.write('{');
+  push();
+}
+
+void JsonWriter::endObject() {
+  if (depth > 0) depth--;
+  out.write('}');
+}
+
+void JsonWriter::beginArray() {
+  beforeValue();
+  out.write('[');
+  push();
+}
+
+void JsonWriter::endArray() {
+  if (depth > 0) depth--;
+  out.write(']');
+}
+
+void JsonWriter::key(const char* name) {
+  beforeValue();
+  writeEscaped(name);
+  out.write(':');
+  afterKey = true;
+}
+
+void JsonWriter::value(const char* text) {
+  beforeValue();
+  if (text == nullptr) {
+    out.write("null");
+    return;
+  }
+  writeEscaped(text);
+}
+
+void JsonWriter::value(bool flag) {
+  beforeValue();
+  out.write(flag ? "true" : "false");
+}
+
+void JsonWriter::value(int number) {
+  value(static_cast<long>(number));
+}
+
+void JsonWriter::value(unsigned number) {
+  value(static_cast<unsigned long>(number));
+}
+
+void JsonWriter::value(long number) {
+  beforeValue();
+  char buf[24];
+  int len = snprintf(buf, sizeof(buf), "%ld", number);
+  out.write(buf, static_cast<size_t>(len));
+}
+
+void JsonWriter::value(unsigned long number) {
+  beforeValue();
+  char buf[24];
+  int len = snprintf(buf, sizeof(buf), "%lu", number);
+  out.write(buf, static_cast<size_t>(len));
+}
+
+void JsonWriter::value(double number) {
+  beforeValue();
+  // JSON has no NaN/Infinity; ArduinoJson writes null for them too.
+  if (isnan(number) || isinf(number)) {
+    out.write("null");
+    return;
+  }
+  char buf[32];
+  int len = snprintf(buf, sizeof(buf), "%.10g", number);
+  out.write(buf, static_cast<size_t>(len));
+}
+
+void JsonWriter::null() {
+  beforeValue();
+  out.write("null");
+}
+
+void JsonWriter::writeEscaped(const char* text) {
+  out.write('"');
+  const char* run = text;
+  for (const char* p = text; *p != '\0'; ++p) {
+    const unsigned char c = static_cast<unsigned char>(*p);
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+    out.write(run, static_cast<size_t>(p - run));
+    run = p + 1;
+    switch (c) {
+      case '"':
+        out.write("\\\"");
+        break;
+      case '\\':
+        out.write("\\\\");
+        break;
+      case '\n':
+        out.write("\\n");
+        break;
+      case '\r':
+        out.write("\\r");
+        break;
+      case '\t':
+        out.write("\\t");
+        break;
+      case '\b':
+        out.write("\\b");
+        break;
+      case '\f':
+        out.write("\\f");
+        break;
+      default: {
+        char esc[7];
+        snprintf(esc, sizeof(esc), "\\u%04x", c);
+        out.write(esc, 6);
+        break;
+      }
+    }
+  }
+  out.write(run, strlen(run));
+  out.write('"');
+}
+
+#ifdef JSON_BENCH
+JsonVariant JsonDocumentWriter::slot() {
+  JsonVariant parent = stack[depth - 1];
+  if (parent.is<JsonArray>()) return parent.add<JsonVariant>();
+  return parent[pendingKey].to<JsonVariant>();
+}
+#endif
@@ -0,0 +1,99 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// Writes JSON straight to a Print (usually a ChunkedWriter) as it is produced,
+// with no JsonDocument or intermediate String. Commas are tracked per nesting
+// level in a fixed bit stack, so the writer itself never allocates.
+class JsonWriter {
+ public:
+  static constexpr uint8_t kMaxDepth = 16;
+
+  explicit JsonWriter(Print& target) : out(target) {}
+
+  void beginObject();
+  void endObject();
+  void beginArray();
+  void endArray();
+  void key(const char* name);
+
+  void value(const char* text);
+  void value(const String& text) { value(text.c_str()); }
+  void value(bool flag);
+  void value(int number);
+  void value(unsigned number);
+  void value(long number);
+  void value(unsigned long number);
+  void value(double number);
+  void null();
+
+  template <typename T>
+  void field(const char* name, const T& v) {
+    key(name);
+    value(v);
+  }
+  void beginObject(const char* name) {
+    key(name);
+    beginObject();
+  }
+  void beginArray(const char* name) {
+    key(name);
+    beginArray();
+  }
+
+ private:
+  // Writes the comma before an array element or object member, if needed.
+  void beforeValue();
+  void push();
+  void writeEscaped(const char* text);
+
+  Print& out;
+  uint16_t hasElements = 0;  // bit d: the container at depth d already has a member
+  uint8_t depth = 0;
+  bool afterKey = false;
+};
+
+#ifdef JSON_BENCH
+// Same interface, building a JsonDocument instead, so the JSON benchmark can
+// produce a body the old sendJson() way from the same emitter template. Only
+// built with -DJSON_BENCH.
+class JsonDocumentWriter {
+ public:
+  explicit JsonDocumentWriter(JsonDocument& target) : doc(target) {}
+
+  void beginObject() { push(depth == 0 ? doc.to<JsonObject>() : slot().to<JsonObject>()); }
+  void endObject() { depth--; }
+  void beginArray() { push(depth == 0 ? doc.to<JsonArray>() : slot().to<JsonArray>()); }
+  void endArray() { depth--; }
+  void key(const char* name) { pendingKey = name; }
+
+  template <typename T>
+  void value(const T& v) {
+    slot().set(v);
+  }
+  void null() { slot().set(nullptr); }
+
+  template <typename T>
+  void field(const char* name, const T& v) {
+    key(name);
+    value(v);
+  }
+  void beginObject(const char* name) {
+    key(name);
+    beginObject();
+  }
+  void beginArray(const char* name) {
+    key(name);
+    beginArray();
+  }
+
+ private:
+  JsonVariant slot();
+  void push(JsonVariant container) { stack[depth++] = container; }
+
+  JsonDocument& doc;
+  JsonVariant stack[JsonWriter::kMaxDepth];
+  uint8_t depth = 0;
+  const char* pendingKey = nullptr;
+};
+#endif
@@ -4,98 +4,200 @@
 
 #include "config.h"
 #include "types.h"
+#include "enum_names.h"
 #include "utils.h"
 #include "display.h"
+#include "raster.h"
+#include "power.h"
 #include "time_sync.h"
 #include "weather.h"
 #include "web_server.h"
+#include "events.h"
+#include "state_version.h"
+#include "udp_control.h"
+#include "reminders.h"
+#include "notes.h"
+#include "persist.h"
 
 Emotion currentEmotion = Emotion::Neutral;
 DisplayMode currentDisplayMode = DisplayMode::Face;
 String speechText = "Hello";
-String notes[kMaxNotes];
-size_t notesCount = 0;
-Reminder reminders[kMaxReminders];
-
-String emotionToString(Emotion emotion) {
-  switch (emotion) {
-    case Emotion::Neutral:
-      return "neutral";
-    case Emotion::Happy:
-      return "happy";
-    case Emotion::Sad:
-      return "sad";
-    case Emotion::Sleepy:
-      return "sleepy";
-    case Emotion::Angry:
-      return "angry";
-    case Emotion::Surprised:
-      return "surprised";
-    case Emotion::Thinking:
-      return "thinking";
-    case Emotion::Love:
-      return "love";
-  }
-  return "neutral";
-}
-
-Emotion parseEmotion(const String& name) {
-  String value = name;
-  value.toLowerCase();
-
-  if (value == "happy") return Emotion::Happy;
-  if (value == "sad") return Emotion::Sad;
-  if (value == "sleepy") return Emotion::Sleepy;
-  if (value == "angry") return Emotion::Angry;
-  if (value == "surprised") return Emotion::Surprised;
-  if (value == "thinking") return Emotion::Thinking;
-  if (value == "love") return Emotion::Love;
-  return Emotion::Neutral;
-}
-
-bool tryParseEmotion(const String& name, Emotion& outEmotion) {
-  String value = name;
-  value.toLowerCase();
-
-  if (value == "neutral") {
-    outEmotion = Emotion::Neutral;
-    return true;
-  }
-  if (value == "happy") {
-    outEmotion = Emotion::Happy;
-    return true;
-  }
-  if (value == "sad") {
-    outEmotion = Emotion::Sad;
-    return true;
-  }
-  if (value == "sleepy") {
-    outEmotion = Emotion::Sleepy;
-    return true;
-  }
-  if (value == "angry") {
-    outEmotion = Emotion::Angry;
-    return true;
-  }
-  if (value == "surprised") {
-    outEmotion = Emotion::Surprised;
-    return true;
-  }
-  if (value == "thinking") {
-    outEmotion = Emotion::Thinking;
-    return true;
-  }
-  if (value == "love") {
-    outEmotion = Emotion::Love;
-    return true;
-  }
-  return false;
-}
+// Longest single loop() pass since boot, excluding the power governor's idle delay.
+uint32_t loopMaxUs = 0;
 
 void setEmotion(Emotion emotion) {
+  noteActivity();
+  if (emotion != currentEmotion) {
+    beginFaceTransition(millis());
+  }
   currentEmotion = emotion;
+  invalidateDisplay();
+  bumpState(StateGroup::Face);
+  persistEmotionChanged();
   Serial.print("Emotion set to: ");
   Serial.println(emotionToString(currentEmotion));
+
+  if (hasEventSubscribers()) {
+    JsonDocument event;
+    event["emotion"] = emotionToString(currentEmotion);
+    publishEvent("emotion", event);
+  }
+}
+
+void setSpeech(const String& text) {
+  noteActivity();
+  speechText = text;
+  if (speechText.length() > kMaxSpeechChars) {
+    speechText = speechText.substring(0, kMaxSpeechChars);
+  }
+  restartSpeechMarquee();
+  invalidateDisplay();
+  bumpState(StateGroup::Face);
+
+  if (hasEventSubscribers()) {
+    JsonDocument event;
+    event["speech"] = speechText;
+    publishEvent("speech", event);
+  }
+}
+
+void setDisplayMode(DisplayMode mode) {
+  noteActivity();
+  currentDisplayMode = mode;
+  invalidateDisplay();
+  bumpState(StateGroup::Face);
+
+  if (hasEventSubscribers()) {
+    JsonDocument event;
+    event["mode"] = displayModeToString(currentDisplayMode);
+    publishEvent("mode", event);
+  }
+}
+
+// Every reminder mutation ends here, so it doubles as the version bump.
+static void publishRemindersEvent() {
+  bumpState(StateGroup::Reminders);
+  if (!hasEventSubscribers()) return;
+  JsonDocument event;
+  event["count"] = reminderCount();
+  publishEvent("reminders", event);
+}
+
+// A full store drops its oldest note.
+size_t addNote(const char* note) {
+  noteActivity();
+  size_t count = noteAdd(note);
+  const char* stored = noteFromNewest(0)->text;
+  bumpState(StateGroup::Notes);
+  persistNoteAdded(stored);
+
+  if (hasEventSubscribers()) {
+    JsonDocument event;
+    event["count"] = count;
+    event["added"] = stored;
+    publishEvent("notes", event);
+  }
+  return count;
+}
+
+static uint64_t minutesFromNow(uint32_t minutes) {
+  return monotonicMs() + static_cast<uint64_t>(minutes) * 60000ULL;
+}
+
+// Deadline of the first fire after `afterUtc` (0 = from now). Wall-clock
+// schedules stay unarmed until the SNTP time and UTC offset are both known;
+// a fire time already in the past is due immediately.
+static void nextReminderDeadline(const Schedule& when, uint32_t afterUtc, uint64_t& dueMs, uint32_t& fireUtc) {
+  dueMs = kReminderUnarmed;
+  fireUtc = 0;
+  if (when.kind == ScheduleKind::Relative) {
+    dueMs = minutesFromNow(when.at);
+    return;
+  }
+  uint32_t utcNow = 0;
+  long utcOffset = 0;
+  if (!getWallClock(utcNow, utcOffset)) return;
+  fireUtc = nextFireUtc(when, afterUtc != 0 ? afterUtc : utcNow - 1, utcOffset);
+  uint64_t now = monotonicMs();
+  dueMs = fireUtc > utcNow ? now + static_cast<uint64_t>(fireUtc - utcNow) * 1000ULL : now;
+}
+
+// Returns the reminder id, or 0 when the pool is full.
+uint32_t addReminder(const Schedule& when, const String& message) {
+  noteActivity();
+  uint64_t dueMs = 0;
+  uint32_t fireUtc = 0;
+  nextReminderDeadline(when, 0, dueMs, fireUtc);
+  uint32_t id = reminderAdd(dueMs, message.c_str(), when, fireUtc);
+  if (id == 0) return 0;
+  persistReminderChanged(id);
+  publishRemindersEvent();
+  return id;
+}
+
+bool cancelReminder(uint32_t id) {
+  noteActivity();
+  if (!reminderCancel(id)) return false;
+  persistReminderRemoved(id);
+  publishRemindersEvent();
+  return true;
+}
+
+// Replaces the schedule and/or the message; either may be null to keep it.
+bool editReminder(uint32_t id, const Schedule* when, const char* message) {
+  noteActivity();
+  if (reminderFind(id) == nullptr) return false;
+  if (when != nullptr) {
+    uint64_t dueMs = 0;
+    uint32_t fireUtc = 0;
+    nextReminderDeadline(*when, 0, dueMs, fireUtc);
+    reminderSetSchedule(id, *when);
+    reminderReschedule(id, dueMs, fireUtc);
+  }
+  if (message != nullptr) reminderSetMessage(id, message);
+  persistReminderChanged(id);
+  publishRemindersEvent();
+  return true;
+}
+
+void clearNotesAndReminders() {
+  noteClearAll();
+  reminderClearAll();
+  persistCleared();
+  bumpState(StateGroup::Notes);
+  setSpeech("Cleared");
+
+  if (hasEventSubscribers()) {
+    JsonDocument event;
+    event["count"] = 0;
+    publishEvent("notes", event);
+  }
+  publishRemindersEvent();
+}
+
+static_assert(kControlMaxSpeech == kMaxSpeechChars, "UDP speech limit must match kMaxSpeechChars");
+
+// Maps a UDP control packet onto the same state the HTTP handlers mutate.
+// Unchanged fields are skipped so a sender streaming its full state at 30 Hz
+// does not re-trigger transitions, events or String copies.
+static void applyControlPacket(const ControlPacket& packet) {
+  uint32_t now = millis();
+  if ((packet.flags & kControlEmotion) && packet.emotion < kEmotionCount) {
+    Emotion emotion = static_cast<Emotion>(packet.emotion);
+    if (emotion != currentEmotion) setEmotion(emotion);
+  }
+  if (packet.flags & kControlSpeech) {
+    if (speechText != packet.speech) setSpeech(packet.speech);
+  }
+  if (packet.flags & kControlGazeRelease) {
+    releaseGaze();
+    invalidateDisplay();
+  }
+  if (packet.flags & kControlGaze) {
+    setGaze(packet.gazeX, packet.gazeY, now);
+    invalidateDisplay();
+  }
+  noteActivity();
 }
 
 void connectWiFi() {
@@ -124,20 +226,87 @@ void connectWiFi() {
   Serial.println(WiFi.softAPIP());
 }
 
+// Clock state the wall-clock deadlines were last derived from.
+static bool armedClockValid = false;
+static uint32_t armedSyncCount = 0;
+static long armedUtcOffset = 0;
+
+// Wall-clock deadlines are monotonic estimates of an SNTP time in a given UTC
+// offset, so re-derive them whenever NTP resyncs or the offset changes.
+static void rearmWallClockReminders() {
+  uint32_t utcNow = 0;
+  long utcOffset = 0;
+  bool valid = getWallClock(utcNow, utcOffset);
+  uint32_t syncCount = sntpSyncCount;
+  if (valid == armedClockValid && syncCount == armedSyncCount && utcOffset == armedUtcOffset) return;
+  bool clockArrived = valid && !armedClockValid;
+  bool localTimesMoved = !armedClockValid || utcOffset != armedUtcOffset;
+  armedClockValid = valid;
+  armedSyncCount = syncCount;
+  armedUtcOffset = utcOffset;
+  if (!valid) return;  // keep the current deadlines until the clock is back
+
+  static uint32_t ids[kMaxReminders];
+  size_t count = reminderIds(ids, kMaxReminders);
+  size_t rearmed = 0;
+  for (size_t i = 0; i < count; ++i) {
+    const Reminder* reminder = reminderFind(ids[i]);
+    if (reminder->schedule.kind == ScheduleKind::Relative) {
+      // Saved before the clock was known, it holds only minutes remaining;
+      // now it can be saved by its wall-clock due time instead.
+      if (clockArrived) persistReminderChanged(ids[i]);
+      continue;
+    }
+    // A plain resync keeps each fire time and only re-derives its deadline, so
+    // a fire the clock step skipped over still happens (immediately).
+    uint32_t after = localTimesMoved || reminder->fireUtc == 0 ? 0 : reminder->fireUtc - 1;
+    uint64_t dueMs = 0;
+    uint32_t fireUtc = 0;
+    nextReminderDeadline(reminder->schedule, after, dueMs, fireUtc);
+    reminderReschedule(ids[i], dueMs, fireUtc);
+    rearmed++;
+  }
+  if (rearmed > 0) {
+    Serial.printf("Re-armed %u wall-clock reminders\n", static_cast<unsigned>(rearmed));
+    publishRemindersEvent();
+  }
+}
+
 void serviceReminders() {
-  uint32_t now = millis();
-  for (size_t i = 0; i < kMaxReminders; ++i) {
-    if (!reminders[i].active) continue;
-
-    if (now >= reminders[i].dueMs) {
-      reminders[i].active = false;
-      setEmotion(Emotion::Surprised);
-      speechText = reminders[i].message;
-      if (speechText.length() > 40) {
-        speechText = speechText.substring(0, 40);
-      }
+  rearmWallClockReminders();
+  // Only the heap root is compared unless something is actually due.
+  uint64_t now = monotonicMs();
+  if (reminderNextDueMs() > now) return;
+
+  const Reminder* due = nullptr;
+  while ((due = reminderDue(now)) != nullptr) {
+    Reminder fired = *due;
+    if (fired.schedule.kind == ScheduleKind::Recurring) {
+      // Next occurrence after this one, skipping any the clock has already
+      // passed: a deadline can land a moment before the SNTP second ticks over.
+      uint32_t after = fired.fireUtc;
+      uint32_t utcNow = 0;
+      long utcOffset = 0;
+      if (getWallClock(utcNow, utcOffset) && utcNow > after) after = utcNow;
+      uint64_t dueMs = 0;
+      uint32_t fireUtc = 0;
+      nextReminderDeadline(fired.schedule, after, dueMs, fireUtc);
+      reminderReschedule(fired.id, dueMs, fireUtc);
+    } else {
+      reminderCancel(fired.id);
+      persistReminderRemoved(fired.id);
     }
+    if (hasEventSubscribers()) {
+      JsonDocument event;
+      event["id"] = fired.id;
+      event["message"] = fired.message;
+      event["recurring"] = fired.schedule.kind == ScheduleKind::Recurring;
+      publishEvent("reminder_fired", event);
+    }
+    setEmotion(Emotion::Surprised);
+    setSpeech(fired.message);
   }
+  publishRemindersEvent();
 }
 
 void setup() {
@@ -149,55 +318,66 @@ void setup() {
   display.setI2CAddress(static_cast<uint8_t>(OLED_I2C_ADDRESS << 1));
   display.begin();
   display.clearBuffer();
+  initRaster();
+  initStateVersion();
+  initInfoClockAtlas();
+  initDisplayPipeline();
+  initPower();
 
 #if EMOTION_BUTTON_PIN >= 0
   pinMode(EMOTION_BUTTON_PIN, INPUT_PULLUP);
 #endif
 
-  for (size_t i = 0; i < kMaxReminders; ++i) {
-    reminders[i].active = false;
-  }
+  initReminders();
+  initPersist();
 
   connectWiFi();
   if (WiFi.status() == WL_CONNECTED) {
     initNtp();
   }
-  speechText = currentIpAddress();
+  setSpeech(currentIpAddress());
+  initWeatherTask();
   serviceInfoData();
   setupServer();
-  scheduleBlink(millis());
-  if (currentDisplayMode == DisplayMode::Info) {
-    drawInfo();
+#if UDP_CONTROL_PORT > 0
+  if (beginUdpControl(UDP_CONTROL_PORT)) {
+    Serial.printf("UDP control on port %d\n", UDP_CONTROL_PORT);
   } else {
-    drawFace();
+    Serial.println("UDP control socket failed");
   }
+#endif
+  scheduleBlink(millis());
+  serviceDisplay();
 }
 
 void loop() {
+  uint32_t loopStartUs = micros();
   server.handleClient();
+  serviceUdpControl(applyControlPacket);
   serviceBlink();
   serviceReminders();
+  servicePersist();
   serviceInfoData();
+  serviceEvents();
+  servicePower();
 
 #if EMOTION_BUTTON_PIN >= 0
   static bool prevPressed = false;
   bool pressed = digitalRead(EMOTION_BUTTON_PIN) == LOW;
   if (pressed && !prevPressed) {
-    int next = (static_cast<int>(currentEmotion) + 1) % 8;
+    int next = (static_cast<int>(currentEmotion) + 1) % static_cast<int>(kEmotionCount);
     setEmotion(static_cast<Emotion>(next));
   }
   prevPressed = pressed;
 #endif
 
-  uint32_t now = millis();
-  if (now >= nextFaceRefreshMs) {
-    uint32_t refreshMs =
-        currentDisplayMode == DisplayMode::Info ? kInfoDisplayRefreshMs : kFaceRefreshMs;
-    nextFaceRefreshMs = now + refreshMs;
-    if (currentDisplayMode == DisplayMode::Info) {
-      drawInfo();
-    } else {
-      drawFace();
-    }
+  serviceDisplay();
+
+  uint32_t loopUs = micros() - loopStartUs;
+  if (loopUs > loopMaxUs) loopMaxUs = loopUs;
+
+  uint32_t idleDelayMs = powerLoopDelayMs();
+  if (idleDelayMs > 0) {
+    delay(idleDelayMs);
   }
 }
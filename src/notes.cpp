@@ -0,0 +1,41 @@
+#include "notes.h"
+
+static Note arena[kMaxNotes];
+static size_t oldest = 0;  // slot of the oldest note
+static size_t count = 0;
+static uint32_t lastSeq = 0;
+
+size_t noteAdd(const char* text) {
+  size_t slot = (oldest + count) % kMaxNotes;
+  if (count == kMaxNotes) {
+    oldest = (oldest + 1) % kMaxNotes;  // the new note takes the oldest's slot
+  } else {
+    count++;
+  }
+
+  Note& note = arena[slot];
+  note.seq = ++lastSeq;
+  size_t length = text != nullptr ? strlen(text) : 0;
+  if (length >= kNoteBytes) {
+    length = kNoteBytes - 1;
+    // Do not leave half a UTF-8 sequence behind.
+    while (length > 0 && (static_cast<uint8_t>(text[length]) & 0xC0) == 0x80) length--;
+  }
+  memcpy(note.text, text, length);
+  note.text[length] = '\0';
+  return count;
+}
+
+void noteClearAll() {
+  oldest = 0;
+  count = 0;
+}
+
+size_t noteCount() {
+  return count;
+}
+
+const Note* noteFromNewest(size_t offset) {
+  if (offset >= count) return nullptr;
+  return &arena[(oldest + count - 1 - offset) % kMaxNotes];
+}
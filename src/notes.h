@@ -0,0 +1,23 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Note store: NOTE_CAPACITY fixed-size slots in one static arena used as a
+// ring buffer. Adding to a full store overwrites the oldest slot, so insert
+// and evict are O(1) and no note ever touches the heap.
+
+static constexpr size_t kMaxNotes = NOTE_CAPACITY;
+static constexpr size_t kNoteBytes = 96;  // including the terminator
+
+struct Note {
+  uint32_t seq;  // 1 for the first note since boot, +1 per note added
+  char text[kNoteBytes];
+};
+
+// Stores `text`, truncated to kNoteBytes - 1 bytes on a UTF-8 boundary, and
+// returns the new count.
+size_t noteAdd(const char* text);
+void noteClearAll();
+size_t noteCount();
+// The note `offset` places back from the newest (0 = newest), or nullptr.
+const Note* noteFromNewest(size_t offset);
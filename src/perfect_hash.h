@@ -0,0 +1,129 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Compile-time perfect hashing for small fixed key sets (enum names, routes).
+//
+// A key set is described by a traits type:
+//
+//   struct Keys {
+//     static constexpr size_t kCount = ...;   // number of keys
+//     static constexpr size_t kSlots = ...;   // power of two, <= 64, >= kCount
+//     static constexpr uint32_t hash(size_t i, uint32_t seed);  // hash of key i
+//   };
+//
+// PerfectHash<Keys> searches for a seed under which every key lands in its own
+// slot and bakes a slot -> key index table into flash. A lookup is then one
+// hash of the input, one table read and one compare against the candidate key;
+// nothing is allocated. Adding a key that makes the search fail is a compile
+// error, fixed by raising kSlots.
+//
+// Everything here is written for C++11 constexpr (single-return functions).
+
+namespace perfect_hash {
+
+static constexpr uint32_t kFnvBasis = 2166136261u;
+static constexpr uint32_t kFnvPrime = 16777619u;
+static constexpr uint32_t kMaxSeed = 256;
+static constexpr uint8_t kEmptySlot = 0xFF;
+
+constexpr char foldAscii(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+constexpr uint32_t mix(uint32_t h, uint8_t byte) {
+  return (h ^ byte) * kFnvPrime;
+}
+
+// Starting state for a seeded hash; `tag` folds in a small discriminator such
+// as the HTTP method.
+constexpr uint32_t start(uint32_t seed, uint8_t tag = 0) {
+  return mix(kFnvBasis ^ (seed * 0x9E3779B9u), tag);
+}
+
+// FNV-1a over a NUL-terminated string. Also used at runtime: the recursion is
+// a tail call and the keys are short.
+constexpr uint32_t hashString(const char* s, uint32_t h) {
+  return *s == '\0' ? h : hashString(s + 1, mix(h, static_cast<uint8_t>(*s)));
+}
+
+constexpr uint32_t hashStringFolded(const char* s, uint32_t h) {
+  return *s == '\0' ? h : hashStringFolded(s + 1, mix(h, static_cast<uint8_t>(foldAscii(*s))));
+}
+
+template <typename Keys>
+constexpr size_t slotOf(size_t i, uint32_t seed) {
+  return Keys::hash(i, seed) & (Keys::kSlots - 1);
+}
+
+// True when keys [i, kCount) all land in slots not yet in `used`.
+template <typename Keys>
+constexpr bool distinctFrom(size_t i, uint32_t seed, uint64_t used) {
+  return i == Keys::kCount ? true
+         : ((used >> slotOf<Keys>(i, seed)) & 1) ? false
+         : distinctFrom<Keys>(i + 1, seed, used | (uint64_t(1) << slotOf<Keys>(i, seed)));
+}
+
+template <typename Keys>
+constexpr uint32_t findSeed(uint32_t seed) {
+  return seed == kMaxSeed ? kMaxSeed
+         : distinctFrom<Keys>(0, seed, 0) ? seed
+         : findSeed<Keys>(seed + 1);
+}
+
+template <typename Keys>
+constexpr uint8_t slotOwner(size_t slot, uint32_t seed, size_t i) {
+  return i == Keys::kCount ? kEmptySlot
+         : slotOf<Keys>(i, seed) == slot ? static_cast<uint8_t>(i)
+         : slotOwner<Keys>(slot, seed, i + 1);
+}
+
+template <size_t Slots>
+struct SlotTable {
+  uint8_t owner[Slots];
+};
+
+template <size_t... I>
+struct IndexList {};
+
+template <size_t N, size_t... I>
+struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...> {};
+
+template <size_t... I>
+struct MakeIndexList<0, I...> {
+  typedef IndexList<I...> type;
+};
+
+template <typename Keys, size_t... I>
+constexpr SlotTable<Keys::kSlots> buildSlots(uint32_t seed, IndexList<I...>) {
+  return SlotTable<Keys::kSlots>{{slotOwner<Keys>(I, seed, 0)...}};
+}
+
+}  // namespace perfect_hash
+
+template <typename Keys>
+struct PerfectHash {
+  static_assert(Keys::kSlots <= 64 && (Keys::kSlots & (Keys::kSlots - 1)) == 0,
+                "kSlots must be a power of two no larger than 64");
+  static_assert(Keys::kCount <= Keys::kSlots && Keys::kCount < perfect_hash::kEmptySlot,
+                "too many keys for the slot table");
+
+  static constexpr uint32_t kSeed = perfect_hash::findSeed<Keys>(0);
+  static_assert(kSeed != perfect_hash::kMaxSeed, "no perfect hash seed found; raise kSlots");
+
+  static constexpr perfect_hash::SlotTable<Keys::kSlots> kTable = perfect_hash::buildSlots<Keys>(
+      kSeed, typename perfect_hash::MakeIndexList<Keys::kSlots>::type());
+
+  // Index of the only key that can match a value with this hash, or kCount.
+  // The caller still compares against that key.
+  static size_t candidate(uint32_t hash) {
+    uint8_t owner = kTable.owner[hash & (Keys::kSlots - 1)];
+    return owner == perfect_hash::kEmptySlot ? Keys::kCount : owner;
+  }
+};
+
+template <typename Keys>
+constexpr uint32_t PerfectHash<Keys>::kSeed;
+
+template <typename Keys>
+constexpr perfect_hash::SlotTable<Keys::kSlots> PerfectHash<Keys>::kTable;
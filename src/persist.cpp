@@ -0,0 +1,281 @@
+#include "persist.h"
+#include "config.h"
+#include "types.h"
+#include "reminders.h"
+#include "notes.h"
+#include "time_sync.h"
+#include "weather.h"
+#include "wal.h"
+
+extern Emotion currentEmotion;
+size_t addNote(const char* note);
+
+// Record types; payloads are little-endian (see WalRecordWriter).
+enum class PersistRecord : uint8_t {
+  Emotion = 1,          // u8 emotion
+  Settings = 2,         // f64 latitude, f64 longitude, u8 fahrenheit
+  NoteAdded = 3,        // str note
+  Cleared = 4,          // notes and reminders
+  Reminder = 5,         // u32 id, u8 kind, u8 days, u32 hours, u64 minutes, u32 at, str message
+  ReminderRemoved = 6,  // u32 id
+  ReminderIds = 7,      // u32 highest reminder id issued
+};
+
+bool persistReady = false;
+uint32_t persistReplayUs = 0;
+
+#if PERSIST_ENABLED
+static LittleFsWalBackend flashBackend;
+#endif
+
+static bool replaying = false;
+// Last-writer-wins state is written once per flush, however often it changed.
+static bool emotionDirty = false;
+static bool settingsDirty = false;
+static bool changesPending = false;
+static uint32_t firstChangeMs = 0;
+static uint32_t lastChangeMs = 0;
+
+static bool recording() {
+  return persistReady && !replaying;
+}
+
+static void noteChange() {
+  uint32_t now = millis();
+  if (!changesPending) firstChangeMs = now;
+  changesPending = true;
+  lastChangeMs = now;
+}
+
+static void append(PersistRecord type, const WalRecordWriter& record) {
+  walAppend(static_cast<uint8_t>(type), record.data, record.length);
+  noteChange();
+}
+
+static void encodeEmotion(WalRecordWriter& record) {
+  record.u8(static_cast<uint8_t>(currentEmotion));
+}
+
+static void encodeSettings(WalRecordWriter& record) {
+  record.f64(infoLatitude);
+  record.f64(infoLongitude);
+  record.u8(infoUseFahrenheit ? 1 : 0);
+}
+
+// A relative deadline means nothing after a reboot, so save it as a local
+// date and time when the clock allows, else as the minutes still to go.
+static Schedule durableSchedule(const Reminder& reminder) {
+  if (reminder.schedule.kind != ScheduleKind::Relative) return reminder.schedule;
+  uint64_t now = monotonicMs();
+  uint64_t remainingMs = reminder.dueMs > now ? reminder.dueMs - now : 0;
+  uint32_t utcNow = 0;
+  long utcOffset = 0;
+  if (getWallClock(utcNow, utcOffset)) {
+    Schedule dated = {};
+    dated.kind = ScheduleKind::Date;
+    dated.at = static_cast<uint32_t>(static_cast<int64_t>(utcNow) + utcOffset + (remainingMs + 999) / 1000);
+    return dated;
+  }
+  return relativeSchedule(static_cast<uint32_t>((remainingMs + 59999) / 60000));
+}
+
+// id, kind, days, hours, minutes, at, then the message's length byte and text.
+static_assert(4 + 1 + 1 + 4 + 8 + 4 + 1 + kReminderMessageBytes - 1 <= kWalMaxPayload,
+              "a reminder record must fit one WAL payload");
+
+static void encodeReminder(const Reminder& reminder, WalRecordWriter& record) {
+  Schedule when = durableSchedule(reminder);
+  record.u32(reminder.id);
+  record.u8(static_cast<uint8_t>(when.kind));
+  record.u8(when.days);
+  record.u32(when.hours);
+  record.u64(when.minutes);
+  record.u32(when.at);
+  record.str(reminder.message, kReminderMessageBytes - 1);
+}
+
+static void applyRecord(uint8_t type, const uint8_t* payload, size_t length) {
+  WalRecordReader in(payload, length);
+  switch (static_cast<PersistRecord>(type)) {
+    case PersistRecord::Emotion: {
+      uint8_t emotion = in.u8();
+      if (in.ok && emotion < kEmotionCount) currentEmotion = static_cast<Emotion>(emotion);
+      break;
+    }
+    case PersistRecord::Settings: {
+      double latitude = in.f64();
+      double longitude = in.f64();
+      bool fahrenheit = in.u8() != 0;
+      if (!in.ok || latitude < -90.0 || latitude > 90.0 || longitude < -180.0 || longitude > 180.0) break;
+      infoLatitude = latitude;
+      infoLongitude = longitude;
+      infoUseFahrenheit = fahrenheit;
+      infoHasCoordinates = true;
+      break;
+    }
+    case PersistRecord::NoteAdded: {
+      char note[kNoteBytes];
+      in.str(note, sizeof(note));
+      if (in.ok) addNote(note);
+      break;
+    }
+    case PersistRecord::Cleared:
+      noteClearAll();
+      reminderClearAll();
+      break;
+    case PersistRecord::Reminder: {
+      uint32_t id = in.u32();
+      Schedule when = {};
+      when.kind = static_cast<ScheduleKind>(in.u8());
+      when.days = in.u8();
+      when.hours = in.u32();
+      when.minutes = in.u64();
+      when.at = in.u32();
+      char message[kReminderMessageBytes];
+      in.str(message, sizeof(message));
+      if (!in.ok || when.kind > ScheduleKind::Recurring) break;
+      // Wall-clock reminders wait, unarmed, for NTP and the UTC offset.
+      uint64_t dueMs = when.kind == ScheduleKind::Relative
+                           ? monotonicMs() + static_cast<uint64_t>(when.at) * 60000ULL
+                           : kReminderUnarmed;
+      reminderRestore(id, dueMs, message, when);
+      break;
+    }
+    case PersistRecord::ReminderRemoved: {
+      uint32_t id = in.u32();
+      if (!in.ok) break;
+      reminderReserveIds(id);
+      reminderCancel(id);
+      break;
+    }
+    case PersistRecord::ReminderIds: {
+      uint32_t id = in.u32();
+      if (in.ok) reminderReserveIds(id);
+      break;
+    }
+  }
+}
+
+static void snapshotRecord(PersistRecord type, const WalRecordWriter& record) {
+  walSnapshotRecord(static_cast<uint8_t>(type), record.data, record.length);
+}
+
+static void writeSnapshot() {
+  WalRecordWriter emotion;
+  encodeEmotion(emotion);
+  snapshotRecord(PersistRecord::Emotion, emotion);
+  WalRecordWriter settings;
+  encodeSettings(settings);
+  snapshotRecord(PersistRecord::Settings, settings);
+  // Oldest first, so replay rebuilds the ring in the same order.
+  for (size_t i = noteCount(); i > 0; --i) {
+    WalRecordWriter note;
+    note.str(noteFromNewest(i - 1)->text, kNoteBytes - 1);
+    snapshotRecord(PersistRecord::NoteAdded, note);
+  }
+  // Cancelled reminders leave no record behind, so keep their ids retired.
+  WalRecordWriter issued;
+  issued.u32(reminderHighestId());
+  snapshotRecord(PersistRecord::ReminderIds, issued);
+  static uint32_t ids[kMaxReminders];
+  size_t count = reminderIds(ids, kMaxReminders);
+  for (size_t i = 0; i < count; ++i) {
+    WalRecordWriter reminder;
+    encodeReminder(*reminderFind(ids[i]), reminder);
+    snapshotRecord(PersistRecord::Reminder, reminder);
+  }
+  emotionDirty = false;
+  settingsDirty = false;
+}
+
+void initPersist() {
+#if PERSIST_ENABLED
+  uint32_t started = micros();
+  replaying = true;
+  bool ok = walOpen(flashBackend, applyRecord, writeSnapshot);
+  replaying = false;
+  persistReplayUs = micros() - started;
+  persistReady = ok;
+  Serial.printf("Persist: %s, %lu records, %lu bytes replayed in %lu us%s\n", ok ? "ready" : "unavailable",
+                static_cast<unsigned long>(walStats.replayRecords), static_cast<unsigned long>(walStats.logBytes),
+                static_cast<unsigned long>(persistReplayUs), walStats.tornTail ? " (damaged tail rewritten)" : "");
+#endif
+}
+
+static void flushPending() {
+  if (emotionDirty) {
+    WalRecordWriter record;
+    encodeEmotion(record);
+    walAppend(static_cast<uint8_t>(PersistRecord::Emotion), record.data, record.length);
+    emotionDirty = false;
+  }
+  if (settingsDirty) {
+    WalRecordWriter record;
+    encodeSettings(record);
+    walAppend(static_cast<uint8_t>(PersistRecord::Settings), record.data, record.length);
+    settingsDirty = false;
+  }
+  walFlush();
+  changesPending = false;
+}
+
+void servicePersist() {
+  if (!persistReady) return;
+  uint32_t now = millis();
+  bool quiet = now - lastChangeMs >= PERSIST_QUIET_MS;
+  if (changesPending) {
+    if (quiet || now - firstChangeMs >= PERSIST_MAX_DELAY_MS) flushPending();
+    return;
+  }
+  if (quiet && walShouldCompact(PERSIST_COMPACT_SLACK_BYTES)) {
+    uint32_t started = millis();
+    bool ok = walCompact(writeSnapshot);
+    Serial.printf("Persist: compacted to %lu bytes in %lu ms%s\n", static_cast<unsigned long>(walStats.logBytes),
+                  static_cast<unsigned long>(millis() - started), ok ? "" : " (failed)");
+  }
+}
+
+void persistEmotionChanged() {
+  if (!recording()) return;
+  emotionDirty = true;
+  noteChange();
+}
+
+void persistSettingsChanged() {
+  if (!recording()) return;
+  settingsDirty = true;
+  noteChange();
+}
+
+void persistNoteAdded(const char* note) {
+  if (!recording()) return;
+  WalRecordWriter record;
+  record.str(note, kNoteBytes - 1);
+  append(PersistRecord::NoteAdded, record);
+}
+
+void persistCleared() {
+  if (!recording()) return;
+  append(PersistRecord::Cleared, WalRecordWriter());
+}
+
+void persistReminderChanged(uint32_t id) {
+  const Reminder* reminder = reminderFind(id);
+  if (!recording() || reminder == nullptr) return;
+  WalRecordWriter record;
+  encodeReminder(*reminder, record);
+  append(PersistRecord::Reminder, record);
+}
+
+void persistReminderRemoved(uint32_t id) {
+  if (!recording()) return;
+  WalRecordWriter record;
+  record.u32(id);
+  append(PersistRecord::ReminderRemoved, record);
+}
+
+uint32_t persistPerDay(uint32_t count) {
+  // At least a minute of uptime, so one boot-time write does not extrapolate wildly.
+  uint64_t uptimeMs = millis() < 60000UL ? 60000ULL : millis();
+  return static_cast<uint32_t>(static_cast<uint64_t>(count) * 86400000ULL / uptimeMs);
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+
+// Keeps notes, reminders, the emotion and the Info settings across reboots in
+// the write-ahead log (src/wal.h) on LittleFS. Mutations call the persist*()
+// hooks below; records are flushed once changes pause for PERSIST_QUIET_MS
+// (or PERSIST_MAX_DELAY_MS at the latest), and the log is compacted during a
+// later quiet period once it has grown well past its last snapshot.
+//
+// Relative reminders are saved by wall-clock due time when the clock is known
+// (they come back as dated reminders), otherwise by minutes remaining, and are
+// saved again by due time once the clock first becomes valid. What stays
+// imprecise: a reboot before that restarts the countdown from the minutes left
+// at the last write, and a saved due time is not moved by later NTP steps.
+
+// Mounts the filesystem and replays the log. Call after initReminders() and
+// before anything reads the restored state.
+void initPersist();
+void servicePersist();
+
+void persistEmotionChanged();
+void persistSettingsChanged();
+void persistNoteAdded(const char* note);
+void persistCleared();  // notes and reminders
+void persistReminderChanged(uint32_t id);
+void persistReminderRemoved(uint32_t id);
+
+extern bool persistReady;
+extern uint32_t persistReplayUs;
+// `count` since boot scaled to a 24-hour rate, for flash wear estimates.
+uint32_t persistPerDay(uint32_t count);
@@ -0,0 +1,113 @@
+#include "power.h"
+#include "config.h"
+#include "display.h"
+
+PowerProfile powerProfile = PowerProfile::Full;
+uint32_t powerWakeCount = 0;
+
+static uint32_t lastActivityMs = 0;
+static uint32_t profileEnteredMs = 0;
+static uint32_t profileTotalsMs[kPowerProfileCount] = {};
+
+struct PowerProfileDef {
+  const char* name;
+  uint32_t minFrameIntervalMs;
+  uint32_t loopDelayMs;
+  uint8_t contrast;
+  bool panelOff;
+  uint32_t cpuMhz;
+};
+
+static constexpr PowerProfileDef kPowerProfileDefs[] = {
+    {"full", 0, 0, kPanelContrastFull, false, kCpuMhzFull},
+    {"reduced", 200, 2, kPanelContrastFull, false, kCpuMhzFull},
+    {"dim", 500, 5, kPanelContrastDim, false, kCpuMhzFull},
+    {"off", 0, 10, kPanelContrastDim, true, kCpuMhzIdle},
+};
+static_assert(sizeof(kPowerProfileDefs) / sizeof(kPowerProfileDefs[0]) == kPowerProfileCount,
+              "kPowerProfileDefs must cover every PowerProfile");
+
+static const PowerProfileDef& profileDef(PowerProfile profile) {
+  return kPowerProfileDefs[static_cast<size_t>(profile)];
+}
+
+static void enterProfile(PowerProfile profile, uint32_t now) {
+  if (profile == powerProfile) return;
+
+  const PowerProfileDef& from = profileDef(powerProfile);
+  const PowerProfileDef& to = profileDef(profile);
+  profileTotalsMs[static_cast<size_t>(powerProfile)] += now - profileEnteredMs;
+  profileEnteredMs = now;
+  powerProfile = profile;
+
+  if (to.cpuMhz != from.cpuMhz) {
+    setCpuFrequencyMhz(to.cpuMhz);
+  }
+  if (to.contrast != from.contrast || to.panelOff != from.panelOff) {
+    setPanelState(to.contrast, to.panelOff);
+  }
+  // Redraw at the new rate, or catch the panel up after it was off.
+  invalidateDisplay();
+
+  Serial.print("Power profile: ");
+  Serial.println(to.name);
+}
+
+void initPower() {
+  lastActivityMs = millis();
+  profileEnteredMs = lastActivityMs;
+  setCpuFrequencyMhz(kCpuMhzFull);
+}
+
+void noteActivity() {
+  uint32_t now = millis();
+  lastActivityMs = now;
+  if (powerProfile != PowerProfile::Full) {
+    powerWakeCount++;
+    enterProfile(PowerProfile::Full, now);
+  }
+}
+
+void servicePower() {
+  uint32_t now = millis();
+  uint32_t idleMs = now - lastActivityMs;
+
+  PowerProfile target = PowerProfile::Full;
+  if (POWER_OFF_AFTER_S > 0 && idleMs >= POWER_OFF_AFTER_S * 1000UL) {
+    target = PowerProfile::Off;
+  } else if (POWER_DIM_AFTER_S > 0 && idleMs >= POWER_DIM_AFTER_S * 1000UL) {
+    target = PowerProfile::Dim;
+  } else if (POWER_REDUCED_AFTER_S > 0 && idleMs >= POWER_REDUCED_AFTER_S * 1000UL) {
+    target = PowerProfile::Reduced;
+  }
+  // Only step down here; noteActivity() handles waking.
+  if (target > powerProfile) {
+    enterProfile(target, now);
+  }
+}
+
+const char* powerProfileToString(PowerProfile profile) {
+  return profileDef(profile).name;
+}
+
+uint32_t powerProfileMs(PowerProfile profile) {
+  uint32_t total = profileTotalsMs[static_cast<size_t>(profile)];
+  if (profile == powerProfile) total += millis() - profileEnteredMs;
+  return total;
+}
+
+uint32_t powerIdleMs() {
+  return millis() - lastActivityMs;
+}
+
+uint32_t powerMinFrameIntervalMs() {
+  return profileDef(powerProfile).minFrameIntervalMs;
+}
+
+bool powerDisplayOff() {
+  return profileDef(powerProfile).panelOff;
+}
+
+uint32_t powerLoopDelayMs() {
+  return profileDef(powerProfile).loopDelayMs;
+}
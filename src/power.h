@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+
+// Power profiles, stepped down as the device sits untouched.
+enum class PowerProfile : uint8_t {
+  Full,     // full animation rate, full contrast, full CPU clock
+  Reduced,  // animation capped at a few frames per second
+  Dim,      // reduced rate and low contrast
+  Off,      // panel asleep, no rendering, lowered CPU clock
+};
+
+static constexpr size_t kPowerProfileCount = static_cast<size_t>(PowerProfile::Off) + 1;
+
+static constexpr uint8_t kPanelContrastFull = 0xCF;
+static constexpr uint8_t kPanelContrastDim = 0x08;
+static constexpr uint32_t kCpuMhzFull = 160;
+// Lowest clock the Wi-Fi stack tolerates.
+static constexpr uint32_t kCpuMhzIdle = 80;
+
+extern PowerProfile powerProfile;
+extern uint32_t powerWakeCount;
+
+void initPower();
+// Records user-facing activity and restores the Full profile immediately.
+void noteActivity();
+// Steps the profile down once the idle thresholds pass. Call from loop().
+void servicePower();
+
+const char* powerProfileToString(PowerProfile profile);
+// Time spent in a profile since boot, including the current stretch.
+uint32_t powerProfileMs(PowerProfile profile);
+uint32_t powerIdleMs();
+// Shortest gap between rendered frames in the current profile (0 = uncapped).
+uint32_t powerMinFrameIntervalMs();
+bool powerDisplayOff();
+// How long loop() may sleep per pass, letting the idle task halt the CPU.
+uint32_t powerLoopDelayMs();
@@ -0,0 +1,238 @@
+#include "raster.h"
+#include "display_pipeline.h"
+#include "render_profile.h"
+
+static constexpr int kDisplayHeight = 64;
+static constexpr int kPatternSpan = 2 * kRasterMaxRadius + 1;
+static_assert(kPatternSpan <= 32, "circle patterns must fit in 32 bits");
+
+// For radius r and column offset d (0..r) from the centre:
+//  discHalf[r][d]       half height of the filled column (rows y0-h..y0+h)
+//  circleRows[r][d]     outline rows as bits, bit (r + dy) for dy in -r..r
+static int8_t discHalf[kRasterMaxRadius + 1][kRasterMaxRadius + 1];
+static uint32_t circleRows[kRasterMaxRadius + 1][kRasterMaxRadius + 1];
+
+enum Quadrant : uint8_t { kUpper = 1, kLower = 2, kLeft = 4, kRight = 8 };
+
+// Bits y0..y1 (inclusive) of a 64-row column, clipped to the screen.
+static inline uint64_t rowSpan(int y0, int y1) {
+  if (y0 < 0) y0 = 0;
+  if (y1 > kDisplayHeight - 1) y1 = kDisplayHeight - 1;
+  if (y1 < y0) return 0;
+  return (~0ULL >> (63 - (y1 - y0))) << y0;
+}
+
+// A pattern whose bit 0 is row `top`, clipped to the screen.
+static inline uint64_t placeRows(uint32_t pattern, int top) {
+  if (top >= kDisplayHeight || top <= -32) return 0;
+  return top >= 0 ? static_cast<uint64_t>(pattern) << top : static_cast<uint64_t>(pattern >> -top);
+}
+
+// ORs a 64-row mask into one column, one page byte at a time.
+static inline void orColumn(uint8_t* frame, int x, uint64_t rows) {
+  if (x < 0 || x >= kDisplayWidth) return;
+  RENDER_PROFILE_PIXELS(static_cast<uint32_t>(__builtin_popcountll(rows)));
+  uint8_t* cell = frame + x;
+  while (rows != 0) {
+    uint8_t bits = static_cast<uint8_t>(rows);
+    if (bits != 0) *cell |= bits;
+    rows >>= 8;
+    cell += kDisplayWidth;
+  }
+}
+
+// U8g2's midpoint circle walk (u8g2_draw_disc / u8g2_draw_circle): calls
+// visit(x, y) for each octant step from (0, r) until x >= y.
+template <typename Visit>
+static void walkCircle(int r, Visit visit) {
+  int f = 1 - r;
+  int ddFx = 1;
+  int ddFy = -2 * r;
+  int x = 0;
+  int y = r;
+  visit(x, y);
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddFy += 2;
+      f += ddFy;
+    }
+    x++;
+    ddFx += 2;
+    f += ddFx;
+    visit(x, y);
+  }
+}
+
+static void buildTables(int r, int8_t* half, uint32_t* rows) {
+  for (int d = 0; d <= r; ++d) {
+    half[d] = -1;
+    rows[d] = 0;
+  }
+  walkCircle(r, [&](int x, int y) {
+    // Disc sections draw columns x0+-x over +-y and x0+-y over +-x.
+    if (y > half[x]) half[x] = static_cast<int8_t>(y);
+    if (x > half[y]) half[y] = static_cast<int8_t>(x);
+    // Circle sections plot (x0+-x, y0+-y) and (x0+-y, y0+-x).
+    rows[x] |= (1UL << (r + y)) | (1UL << (r - y));
+    rows[y] |= (1UL << (r + x)) | (1UL << (r - x));
+  });
+}
+
+void initRaster() {
+  for (int r = 0; r <= kRasterMaxRadius; ++r) {
+    buildTables(r, discHalf[r], circleRows[r]);
+  }
+}
+
+void rasterPixel(uint8_t* frame, int x, int y) {
+  RENDER_PROFILE_SCOPE(RenderPrimitive::Pixel);
+  if (x < 0 || x >= kDisplayWidth || y < 0 || y >= kDisplayHeight) return;
+  RENDER_PROFILE_PIXELS(1);
+  frame[(y >> 3) * kDisplayWidth + x] |= static_cast<uint8_t>(1U << (y & 7));
+}
+
+void rasterHLine(uint8_t* frame, int x, int y, int w) {
+  RENDER_PROFILE_SCOPE(RenderPrimitive::HLine);
+  if (y < 0 || y >= kDisplayHeight || w <= 0) return;
+  int x2 = x + w;
+  if (x < 0) x = 0;
+  if (x2 > kDisplayWidth) x2 = kDisplayWidth;
+  RENDER_PROFILE_PIXELS(x2 > x ? static_cast<uint32_t>(x2 - x) : 0);
+  uint8_t* row = frame + (y >> 3) * kDisplayWidth;
+  const uint8_t bit = static_cast<uint8_t>(1U << (y & 7));
+  for (int cx = x; cx < x2; ++cx) {
+    row[cx] |= bit;
+  }
+}
+
+void rasterBox(uint8_t* frame, int x, int y, int w, int h) {
+  RENDER_PROFILE_SCOPE(RenderPrimitive::Box);
+  if (w <= 0 || h <= 0) return;
+  const uint64_t rows = rowSpan(y, y + h - 1);
+  for (int cx = x; cx < x + w; ++cx) {
+    orColumn(frame, cx, rows);
+  }
+}
+
+void rasterLine(uint8_t* frame, int x1, int y1, int x2, int y2) {
+  RENDER_PROFILE_SCOPE(RenderPrimitive::Line);
+  // Same Bresenham variant as u8g2_DrawLine, so endpoints and steps match.
+  int dx = x1 > x2 ? x1 - x2 : x2 - x1;
+  int dy = y1 > y2 ? y1 - y2 : y2 - y1;
+  bool swapXY = false;
+  if (dy > dx) {
+    swapXY = true;
+    int tmp = dx;
+    dx = dy;
+    dy = tmp;
+    tmp = x1;
+    x1 = y1;
+    y1 = tmp;
+    tmp = x2;
+    x2 = y2;
+    y2 = tmp;
+  }
+  if (x1 > x2) {
+    int tmp = x1;
+    x1 = x2;
+    x2 = tmp;
+    tmp = y1;
+    y1 = y2;
+    y2 = tmp;
+  }
+  int err = dx >> 1;
+  const int ystep = y2 > y1 ? 1 : -1;
+  int y = y1;
+  for (int x = x1; x <= x2; ++x) {
+    if (swapXY) {
+      rasterPixel(frame, y, x);
+    } else {
+      rasterPixel(frame, x, y);
+    }
+    err -= dy;
+    if (err < 0) {
+      y += ystep;
+      err += dx;
+    }
+  }
+}
+
+// Filled disc quadrants around (x0, y0); `quadrants` is a kUpper/kLower x kLeft/kRight mask.
+static void discQuadrants(uint8_t* frame, int x0, int y0, int r, uint8_t quadrants) {
+  if (r < 0) return;
+  auto column = [&](int d, int h) {
+    const uint64_t rows = rowSpan((quadrants & kUpper) ? y0 - h : y0, (quadrants & kLower) ? y0 + h : y0);
+    if (quadrants & kLeft) orColumn(frame, x0 - d, rows);
+    if (quadrants & kRight) orColumn(frame, x0 + d, rows);
+  };
+  if (r > kRasterMaxRadius) {
+    // Radii past the table are walked directly; overlapping spans are harmless.
+    walkCircle(r, [&](int x, int y) {
+      column(x, y);
+      column(y, x);
+    });
+    return;
+  }
+  const int8_t* half = discHalf[r];
+  for (int d = 0; d <= r; ++d) {
+    if (half[d] >= 0) column(d, half[d]);
+  }
+}
+
+void rasterDisc(uint8_t* frame, int x0, int y0, int r) {
+  RENDER_PROFILE_SCOPE(RenderPrimitive::Disc);
+  discQuadrants(frame, x0, y0, r, kUpper | kLower | kLeft | kRight);
+}
+
+void rasterCircle(uint8_t* frame, int x0, int y0, int r) {
+  RENDER_PROFILE_SCOPE(RenderPrimitive::Circle);
+  if (r < 0) return;
+  if (r > kRasterMaxRadius) {
+    walkCircle(r, [&](int x, int y) {
+      rasterPixel(frame, x0 + x, y0 - y);
+      rasterPixel(frame, x0 + y, y0 - x);
+      rasterPixel(frame, x0 - x, y0 - y);
+      rasterPixel(frame, x0 - y, y0 - x);
+      rasterPixel(frame, x0 + x, y0 + y);
+      rasterPixel(frame, x0 + y, y0 + x);
+      rasterPixel(frame, x0 - x, y0 + y);
+      rasterPixel(frame, x0 - y, y0 + x);
+    });
+    return;
+  }
+  for (int d = 0; d <= r; ++d) {
+    const uint64_t rows = placeRows(circleRows[r][d], y0 - r);
+    orColumn(frame, x0 - d, rows);
+    if (d != 0) orColumn(frame, x0 + d, rows);
+  }
+}
+
+void rasterRBox(uint8_t* frame, int x, int y, int w, int h, int r) {
+  RENDER_PROFILE_SCOPE(RenderPrimitive::RBox);
+  // Mirrors u8g2_DrawRBox: four quarter discs plus up to three boxes.
+  int xl = x + r;
+  int yu = y + r;
+  const int xr = x + w - r - 1;
+  const int yl = y + h - r - 1;
+
+  discQuadrants(frame, xl, yu, r, kUpper | kLeft);
+  discQuadrants(frame, xr, yu, r, kUpper | kRight);
+  discQuadrants(frame, xl, yl, r, kLower | kLeft);
+  discQuadrants(frame, xr, yl, r, kLower | kRight);
+
+  int ww = w - r - r;
+  xl++;
+  yu++;
+  if (ww >= 3) {
+    ww -= 2;
+    rasterBox(frame, xl, y, ww, r + 1);
+    rasterBox(frame, xl, yl, ww, r + 1);
+  }
+
+  int hh = h - r - r;
+  if (hh >= 3) {
+    hh -= 2;
+    rasterBox(frame, x, yu, w, hh);
+  }
+}
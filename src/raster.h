@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+
+// Direct rasterizer for the face primitives. Writes straight into the SSD1306
+// page buffer (8 pages x 128 columns, bit 0 = top row of the page), one column
+// span at a time, instead of plotting pixels through U8g2. Shapes follow U8g2's
+// own algorithms so frames are pixel-identical. Draw color 1 (set) only.
+
+// Largest disc/circle radius served from the span tables; bigger ones are
+// computed on the fly with the same algorithm.
+static constexpr int kRasterMaxRadius = 12;
+
+// Builds the per-radius span tables. Call once at startup.
+void initRaster();
+
+void rasterPixel(uint8_t* frame, int x, int y);
+void rasterHLine(uint8_t* frame, int x, int y, int w);
+void rasterBox(uint8_t* frame, int x, int y, int w, int h);
+void rasterLine(uint8_t* frame, int x1, int y1, int x2, int y2);
+void rasterDisc(uint8_t* frame, int x0, int y0, int r);
+void rasterCircle(uint8_t* frame, int x0, int y0, int r);
+void rasterRBox(uint8_t* frame, int x, int y, int w, int h, int r);
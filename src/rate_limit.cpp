@@ -0,0 +1,119 @@
+#include "rate_limit.h"
+#include "config.h"
+
+// Tokens are kept in thousandths so a rate in tokens per second refills
+// exactly `rate` milli-tokens per millisecond.
+static constexpr uint32_t kTokenCost = 1000;
+
+struct BucketConfig {
+  uint32_t perSecond;  // 0 = unlimited
+  uint32_t burst;
+};
+
+static constexpr BucketConfig kClassBuckets[kRouteClassCount] = {
+    {RATE_READ_PER_S, RATE_READ_BURST},
+    {RATE_MUTATE_PER_S, RATE_MUTATE_BURST},
+    {RATE_UI_PER_S, RATE_UI_BURST},
+};
+static constexpr BucketConfig kGlobalBucket = {RATE_GLOBAL_PER_S, RATE_GLOBAL_BURST};
+
+static const char* const kRouteClassNames[kRouteClassCount] = {"read", "mutate", "ui"};
+
+struct TokenBucket {
+  uint32_t tokens;
+  uint32_t refilledMs;
+};
+
+struct RateClient {
+  bool used;
+  uint32_t ip;
+  uint32_t lastSeenMs;
+  TokenBucket buckets[kRouteClassCount];
+};
+
+uint32_t rateAccepted[kRouteClassCount] = {};
+uint32_t rateRejected[kRouteClassCount] = {};
+uint32_t rateRejectedGlobal = 0;
+uint32_t rateClientsEvicted = 0;
+
+static RateClient clients[kMaxRateClients];
+static TokenBucket globalBucket = {kGlobalBucket.burst * kTokenCost, 0};
+
+const char* routeClassToString(RouteClass routeClass) {
+  return kRouteClassNames[static_cast<size_t>(routeClass)];
+}
+
+static void refill(TokenBucket& bucket, const BucketConfig& config, uint32_t now) {
+  uint32_t capacity = config.burst * kTokenCost;
+  uint32_t elapsed = now - bucket.refilledMs;
+  bucket.refilledMs = now;
+  // Cap elapsed first so the product cannot overflow after a long idle spell.
+  if (elapsed >= capacity / config.perSecond + 1) {
+    bucket.tokens = capacity;
+    return;
+  }
+  bucket.tokens += elapsed * config.perSecond;
+  if (bucket.tokens > capacity) bucket.tokens = capacity;
+}
+
+// Milliseconds until `bucket` holds a whole token; 0 if it already does.
+static uint32_t waitForToken(const TokenBucket& bucket, const BucketConfig& config) {
+  if (bucket.tokens >= kTokenCost) return 0;
+  return (kTokenCost - bucket.tokens + config.perSecond - 1) / config.perSecond;
+}
+
+static RateClient& clientFor(uint32_t ip, uint32_t now) {
+  RateClient* oldest = &clients[0];
+  for (size_t i = 0; i < kMaxRateClients; ++i) {
+    RateClient& client = clients[i];
+    if (client.used && client.ip == ip) return client;
+    if (!client.used) {
+      oldest = &client;
+      break;
+    }
+    if (now - client.lastSeenMs > now - oldest->lastSeenMs) oldest = &client;
+  }
+
+  if (oldest->used) rateClientsEvicted++;
+  oldest->used = true;
+  oldest->ip = ip;
+  for (size_t c = 0; c < kRouteClassCount; ++c) {
+    oldest->buckets[c].tokens = kClassBuckets[c].burst * kTokenCost;
+    oldest->buckets[c].refilledMs = now;
+  }
+  return *oldest;
+}
+
+bool admitRequest(uint32_t clientIp, RouteClass routeClass, uint32_t now, uint32_t& retryAfterMs) {
+  size_t index = static_cast<size_t>(routeClass);
+  const BucketConfig& config = kClassBuckets[index];
+  retryAfterMs = 0;
+
+  TokenBucket* classBucket = nullptr;
+  if (config.perSecond > 0) {
+    RateClient& client = clientFor(clientIp, now);
+    client.lastSeenMs = now;
+    classBucket = &client.buckets[index];
+    refill(*classBucket, config, now);
+    retryAfterMs = waitForToken(*classBucket, config);
+  }
+
+  bool globalLimited = false;
+  if (kGlobalBucket.perSecond > 0) {
+    refill(globalBucket, kGlobalBucket, now);
+    uint32_t globalWait = waitForToken(globalBucket, kGlobalBucket);
+    globalLimited = globalWait > 0;
+    if (globalWait > retryAfterMs) retryAfterMs = globalWait;
+  }
+
+  if (retryAfterMs > 0) {
+    rateRejected[index]++;
+    if (globalLimited) rateRejectedGlobal++;
+    return false;
+  }
+
+  if (classBucket != nullptr) classBucket->tokens -= kTokenCost;
+  if (kGlobalBucket.perSecond > 0) globalBucket.tokens -= kTokenCost;
+  rateAccepted[index]++;
+  return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <Arduino.h>
+
+// Admission control for the HTTP API: a token bucket per client IP and route
+// class, plus one bucket shared by every client. Rates and bursts come from
+// include/config.h. Memory is fixed: kMaxRateClients clients are tracked and
+// the least recently seen one is recycled for a new address.
+
+enum class RouteClass : uint8_t {
+  Read,    // GET API: /status, /notes, /events, /debug/*
+  Mutate,  // POST API
+  Ui,      // control panel assets and /ui/* form posts
+};
+
+static constexpr size_t kRouteClassCount = static_cast<size_t>(RouteClass::Ui) + 1;
+static constexpr size_t kMaxRateClients = 8;
+
+const char* routeClassToString(RouteClass routeClass);
+
+// Takes one token for `clientIp` in `routeClass` and one from the global bucket.
+// On refusal nothing is taken and `retryAfterMs` says when a token will be free.
+bool admitRequest(uint32_t clientIp, RouteClass routeClass, uint32_t now, uint32_t& retryAfterMs);
+
+extern uint32_t rateAccepted[kRouteClassCount];
+extern uint32_t rateRejected[kRouteClassCount];
+extern uint32_t rateRejectedGlobal;  // refused by the shared bucket (also in rateRejected)
+extern uint32_t rateClientsEvicted;
@@ -0,0 +1,231 @@
+#include "reminders.h"
+#include <algorithm>
+#include <esp_timer.h>
+
+static Reminder pool[kMaxReminders];
+// Bumped each time a slot is reused, so ids (generation * capacity + slot)
+// stay unique and a stale id never resolves to a newer reminder. New ids are
+// also kept above every id issued before, including those replayed from flash,
+// so the guarantee holds across reboots.
+static uint32_t slotGeneration[kMaxReminders];
+static uint32_t highestId = 0;
+static uint16_t freeSlots[kMaxReminders];
+static size_t freeCount = 0;
+
+// heap[0] is the earliest deadline; heapIndex[slot] locates a slot in the heap.
+static uint16_t heap[kMaxReminders];
+static uint16_t heapIndex[kMaxReminders];
+static size_t heapSize = 0;
+
+uint64_t monotonicMs() {
+  return static_cast<uint64_t>(esp_timer_get_time()) / 1000ULL;
+}
+
+static bool earlier(uint16_t a, uint16_t b) {
+  const Reminder& ra = pool[a];
+  const Reminder& rb = pool[b];
+  return ra.dueMs != rb.dueMs ? ra.dueMs < rb.dueMs : ra.id < rb.id;
+}
+
+static void heapPlace(size_t index, uint16_t slot) {
+  heap[index] = slot;
+  heapIndex[slot] = static_cast<uint16_t>(index);
+}
+
+static void siftUp(size_t index) {
+  uint16_t slot = heap[index];
+  while (index > 0) {
+    size_t parent = (index - 1) / 2;
+    if (!earlier(slot, heap[parent])) break;
+    heapPlace(index, heap[parent]);
+    index = parent;
+  }
+  heapPlace(index, slot);
+}
+
+static void siftDown(size_t index) {
+  uint16_t slot = heap[index];
+  while (true) {
+    size_t child = index * 2 + 1;
+    if (child >= heapSize) break;
+    if (child + 1 < heapSize && earlier(heap[child + 1], heap[child])) child++;
+    if (!earlier(heap[child], slot)) break;
+    heapPlace(index, heap[child]);
+    index = child;
+  }
+  heapPlace(index, slot);
+}
+
+static void heapRemove(size_t index) {
+  heapSize--;
+  if (index == heapSize) return;
+  heapPlace(index, heap[heapSize]);
+  siftDown(index);
+  siftUp(heapIndex[heap[index]]);
+}
+
+static void copyMessage(char* dest, const char* message) {
+  size_t length = message != nullptr ? strlen(message) : 0;
+  if (length >= kReminderMessageBytes) {
+    length = kReminderMessageBytes - 1;
+    // Do not leave half a UTF-8 sequence behind.
+    while (length > 0 && (static_cast<uint8_t>(message[length]) & 0xC0) == 0x80) length--;
+  }
+  memcpy(dest, message, length);
+  dest[length] = '\0';
+}
+
+static Reminder* lookup(uint32_t id) {
+  if (id == 0) return nullptr;
+  Reminder& reminder = pool[id % kMaxReminders];
+  return reminder.id == id ? &reminder : nullptr;
+}
+
+static uint16_t slotOf(const Reminder& reminder) {
+  return static_cast<uint16_t>(&reminder - pool);
+}
+
+static void releaseSlot(Reminder& reminder) {
+  reminder.id = 0;
+  freeSlots[freeCount++] = slotOf(reminder);
+}
+
+void initReminders() {
+  heapSize = 0;
+  freeCount = 0;
+  // Pushed in reverse so slot 0 is handed out first.
+  for (size_t i = kMaxReminders; i > 0; --i) {
+    pool[i - 1].id = 0;
+    freeSlots[freeCount++] = static_cast<uint16_t>(i - 1);
+  }
+}
+
+uint32_t reminderAdd(uint64_t dueMs, const char* message, const Schedule& schedule, uint32_t fireUtc) {
+  if (freeCount == 0) return 0;
+  uint16_t slot = freeSlots[--freeCount];
+  Reminder& reminder = pool[slot];
+  const uint32_t floorGeneration = highestId / kMaxReminders;
+  if (slotGeneration[slot] < floorGeneration) slotGeneration[slot] = floorGeneration;
+  slotGeneration[slot]++;
+  reminder.id = slotGeneration[slot] * kMaxReminders + slot;
+  highestId = reminder.id;
+  reminder.fireUtc = fireUtc;
+  reminder.dueMs = dueMs;
+  reminder.schedule = schedule;
+  copyMessage(reminder.message, message);
+
+  heapPlace(heapSize, slot);
+  siftUp(heapSize++);
+  return reminder.id;
+}
+
+bool reminderRestore(uint32_t id, uint64_t dueMs, const char* message, const Schedule& schedule) {
+  if (id == 0) return false;
+  reminderReserveIds(id);
+  uint16_t slot = static_cast<uint16_t>(id % kMaxReminders);
+  Reminder& reminder = pool[slot];
+  if (reminder.id == id) {
+    reminderSetSchedule(id, schedule);
+    reminderSetMessage(id, message);
+    return reminderReschedule(id, dueMs, 0);
+  }
+  if (reminder.id != 0) return false;
+  // Take the slot off the free stack; only done at boot, so a scan is fine.
+  for (size_t i = 0; i < freeCount; ++i) {
+    if (freeSlots[i] == slot) {
+      freeSlots[i] = freeSlots[--freeCount];
+      break;
+    }
+  }
+  slotGeneration[slot] = id / kMaxReminders;
+  reminder.id = id;
+  reminder.fireUtc = 0;
+  reminder.dueMs = dueMs;
+  reminder.schedule = schedule;
+  copyMessage(reminder.message, message);
+  heapPlace(heapSize, slot);
+  siftUp(heapSize++);
+  return true;
+}
+
+bool reminderCancel(uint32_t id) {
+  Reminder* reminder = lookup(id);
+  if (reminder == nullptr) return false;
+  heapRemove(heapIndex[slotOf(*reminder)]);
+  releaseSlot(*reminder);
+  return true;
+}
+
+bool reminderReschedule(uint32_t id, uint64_t dueMs, uint32_t fireUtc) {
+  Reminder* reminder = lookup(id);
+  if (reminder == nullptr) return false;
+  reminder->fireUtc = fireUtc;
+  reminder->dueMs = dueMs;
+  size_t index = heapIndex[slotOf(*reminder)];
+  siftDown(index);
+  siftUp(heapIndex[slotOf(*reminder)]);
+  return true;
+}
+
+bool reminderSetSchedule(uint32_t id, const Schedule& schedule) {
+  Reminder* reminder = lookup(id);
+  if (reminder == nullptr) return false;
+  reminder->schedule = schedule;
+  return true;
+}
+
+bool reminderSetMessage(uint32_t id, const char* message) {
+  Reminder* reminder = lookup(id);
+  if (reminder == nullptr) return false;
+  copyMessage(reminder->message, message);
+  return true;
+}
+
+const Reminder* reminderFind(uint32_t id) {
+  return lookup(id);
+}
+
+void reminderReserveIds(uint32_t throughId) {
+  if (throughId > highestId) highestId = throughId;
+}
+
+uint32_t reminderHighestId() {
+  return highestId;
+}
+
+void reminderClearAll() {
+  while (heapSize > 0) {
+    releaseSlot(pool[heap[--heapSize]]);
+  }
+}
+
+size_t reminderCount() {
+  return heapSize;
+}
+
+uint64_t reminderNextDueMs() {
+  return heapSize > 0 ? pool[heap[0]].dueMs : UINT64_MAX;
+}
+
+const Reminder* reminderDue(uint64_t now) {
+  if (heapSize == 0 || pool[heap[0]].dueMs > now) return nullptr;
+  return &pool[heap[0]];
+}
+
+size_t reminderIds(uint32_t* out, size_t max) {
+  size_t count = std::min(max, heapSize);
+  for (size_t i = 0; i < count; ++i) out[i] = pool[heap[i]].id;
+  return count;
+}
+
+size_t remindersByDue(const Reminder** out, size_t max) {
+  // The heap only orders its root; sort a copy of the pointers for listing.
+  // Static rather than on the stack: it is 1 KB at the default capacity.
+  static const Reminder* all[kMaxReminders];
+  size_t count = std::min(max, heapSize);
+  for (size_t i = 0; i < heapSize; ++i) all[i] = &pool[heap[i]];
+  auto byDue = [](const Reminder* a, const Reminder* b) { return earlier(slotOf(*a), slotOf(*b)); };
+  std::partial_sort(all, all + count, all + heapSize, byDue);
+  std::copy(all, all + count, out);
+  return count;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "schedule.h"
+#include "types.h"
+
+// Reminder engine: a fixed pool of REMINDER_CAPACITY slots ordered by a binary
+// min-heap on a 64-bit monotonic deadline, so millis() wrap-around and
+// minutes-to-ms overflow cannot misfire a reminder, and the per-loop check
+// only looks at the heap root. Wall-clock schedules are converted to a
+// monotonic deadline by the caller; the engine only stores the result.
+
+static constexpr size_t kMaxReminders = REMINDER_CAPACITY;
+// A fired reminder is spoken, so it holds as much as the speech line shows.
+static constexpr size_t kReminderMessageBytes = kMaxSpeechChars + 1;  // including the terminator
+static_assert(kMaxReminders > 0 && kMaxReminders < 0xFFFF, "REMINDER_CAPACITY must fit a uint16_t slot index");
+// Deadline of a wall-clock reminder waiting for the local time to be known.
+static constexpr uint64_t kReminderUnarmed = UINT64_MAX;
+
+struct Reminder {
+  uint32_t id;       // never 0 for a live reminder
+  uint32_t fireUtc;  // UTC seconds dueMs was derived from; 0 for relative or unarmed
+  uint64_t dueMs;    // on the monotonicMs() clock
+  Schedule schedule;
+  char message[kReminderMessageBytes];
+};
+
+// Milliseconds since boot, 64-bit so it never wraps.
+uint64_t monotonicMs();
+
+void initReminders();
+
+// Returns the new reminder's id, or 0 when the pool is full. Messages past
+// kMaxSpeechChars bytes are truncated on a UTF-8 boundary, where setSpeech()
+// would have cut them anyway.
+uint32_t reminderAdd(uint64_t dueMs, const char* message, const Schedule& schedule, uint32_t fireUtc);
+// Recreates a reminder under a known id (replaying saved state), or updates
+// it if that id is already live; false if its slot holds another reminder.
+bool reminderRestore(uint32_t id, uint64_t dueMs, const char* message, const Schedule& schedule);
+// Ids up to `throughId` are never handed out again, even in free slots. Used
+// when replaying saved state, which only holds the reminders still alive.
+void reminderReserveIds(uint32_t throughId);
+uint32_t reminderHighestId();
+bool reminderCancel(uint32_t id);
+bool reminderReschedule(uint32_t id, uint64_t dueMs, uint32_t fireUtc);
+// Replaces the schedule only; follow with reminderReschedule.
+bool reminderSetSchedule(uint32_t id, const Schedule& schedule);
+bool reminderSetMessage(uint32_t id, const char* message);
+const Reminder* reminderFind(uint32_t id);
+void reminderClearAll();
+size_t reminderCount();
+
+// Earliest deadline, or UINT64_MAX when there are no reminders.
+uint64_t reminderNextDueMs();
+// The earliest reminder if it is due at `now`, else nullptr. The caller
+// cancels or reschedules it before asking again.
+const Reminder* reminderDue(uint64_t now);
+// Copies up to `max` live ids, in no particular order; returns the count.
+size_t reminderIds(uint32_t* out, size_t max);
+// Fills `out` with up to `max` reminders, soonest first; returns the count.
+size_t remindersByDue(const Reminder** out, size_t max);
@@ -0,0 +1,44 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-primitive accounting for the host render benchmark (test/render). The
+// firmware is built without RENDER_PROFILE, so the hooks compile to nothing.
+
+enum class RenderPrimitive : uint8_t { Pixel, HLine, Box, Line, Disc, Circle, RBox, Triangle, Text, Glyph };
+static constexpr size_t kRenderPrimitiveCount = static_cast<size_t>(RenderPrimitive::Glyph) + 1;
+
+#ifdef RENDER_PROFILE
+struct RenderPrimitiveStats {
+  uint64_t calls;
+  uint64_t pixels;  // pixels written, whether or not they were already set
+  uint64_t ns;
+};
+
+extern bool renderProfileEnabled;
+extern RenderPrimitiveStats renderPrimitiveStats[kRenderPrimitiveCount];
+
+const char* renderPrimitiveName(RenderPrimitive primitive);
+void resetRenderProfile();
+
+// Times the outermost primitive in progress and credits it with every pixel
+// written until it returns, so a line's own pixel calls are not counted twice.
+class RenderProfileScope {
+ public:
+  explicit RenderProfileScope(RenderPrimitive primitive);
+  ~RenderProfileScope();
+
+ private:
+  bool outermost;
+  RenderPrimitive primitive;
+  uint64_t startedNs;
+};
+
+void renderProfilePixels(uint32_t count);
+
+#define RENDER_PROFILE_SCOPE(primitive) RenderProfileScope renderProfileScope(primitive)
+#define RENDER_PROFILE_PIXELS(count) renderProfilePixels(count)
+#else
+#define RENDER_PROFILE_SCOPE(primitive)
+#define RENDER_PROFILE_PIXELS(count)
+#endif
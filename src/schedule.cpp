@@ -0,0 +1,316 @@
+#include "schedule.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static constexpr uint8_t kAllDays = 0x7F;
+static constexpr int kMinYear = 2020;
+static constexpr int kMaxYear = 2105;  // local epoch seconds must fit a uint32_t
+
+Schedule relativeSchedule(uint32_t minutes) {
+  Schedule schedule = {};
+  schedule.kind = ScheduleKind::Relative;
+  schedule.at = minutes;
+  return schedule;
+}
+
+static bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Reads 1..maxDigits decimal digits.
+static bool readNumber(const char*& p, const char* end, unsigned maxDigits, unsigned& out) {
+  out = 0;
+  unsigned digits = 0;
+  while (p < end && isDigit(*p) && digits < maxDigits) {
+    out = out * 10 + static_cast<unsigned>(*p++ - '0');
+    digits++;
+  }
+  return digits > 0 && (p == end || !isDigit(*p));
+}
+
+// One cron field in [begin, end) into `mask`, bit v set for each listed value in [lo, hi].
+static bool parseCronField(const char* begin, const char* end, unsigned lo, unsigned hi, uint64_t& mask) {
+  mask = 0;
+  const char* p = begin;
+  while (p < end) {
+    unsigned first = lo;
+    unsigned last = hi;
+    unsigned step = 1;
+    bool single = false;
+    if (*p == '*') {
+      p++;
+    } else {
+      if (!readNumber(p, end, 2, first)) return false;
+      last = first;
+      single = true;
+      if (p < end && *p == '-') {
+        p++;
+        if (!readNumber(p, end, 2, last)) return false;
+        single = false;
+      }
+    }
+    if (p < end && *p == '/') {
+      p++;
+      if (!readNumber(p, end, 2, step) || step == 0) return false;
+      if (single) last = hi;  // "5/15" means 5, 20, 35, 50
+    }
+    if (first < lo || last > hi || first > last) return false;
+    for (unsigned v = first; v <= last; v += step) mask |= 1ULL << v;
+    if (p < end) {
+      if (*p != ',' || p + 1 == end) return false;
+      p++;
+    }
+  }
+  return mask != 0;
+}
+
+static bool isSpace(char c) {
+  return c == ' ' || c == '\t';
+}
+
+const char* parseCronSchedule(const char* text, Schedule& out) {
+  const char* fields[5][2];
+  size_t count = 0;
+  const char* p = text;
+  while (true) {
+    while (isSpace(*p)) p++;
+    if (*p == '\0') break;
+    if (count == 5) return "Expected 5 cron fields";
+    fields[count][0] = p;
+    while (*p != '\0' && !isSpace(*p)) p++;
+    fields[count++][1] = p;
+  }
+  if (count != 5) return "Expected 5 cron fields";
+  for (size_t i = 2; i < 4; ++i) {
+    if (fields[i][1] - fields[i][0] != 1 || *fields[i][0] != '*') {
+      return "Cron day-of-month and month must be *";
+    }
+  }
+
+  uint64_t minutes = 0;
+  uint64_t hours = 0;
+  uint64_t days = 0;
+  if (!parseCronField(fields[0][0], fields[0][1], 0, 59, minutes)) return "Invalid cron minute";
+  if (!parseCronField(fields[1][0], fields[1][1], 0, 23, hours)) return "Invalid cron hour";
+  if (!parseCronField(fields[4][0], fields[4][1], 0, 7, days)) return "Invalid cron day-of-week";
+  if (days & (1ULL << 7)) days = (days | 1ULL) & kAllDays;  // 7 is Sunday too
+
+  out = Schedule();
+  out.kind = ScheduleKind::Recurring;
+  out.minutes = minutes;
+  out.hours = static_cast<uint32_t>(hours);
+  out.days = static_cast<uint8_t>(days);
+  return nullptr;
+}
+
+static bool isLeapYear(unsigned year) {
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static unsigned daysInMonth(unsigned year, unsigned month) {
+  static const uint8_t kDays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  return month == 2 && isLeapYear(year) ? 29 : kDays[month - 1];
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's algorithm),
+// restricted to years after 1970 so everything stays unsigned.
+static uint32_t daysFromCivil(unsigned year, unsigned month, unsigned day) {
+  year -= month <= 2;
+  unsigned era = year / 400;
+  unsigned yoe = year - era * 400;
+  unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void civilFromDays(uint32_t days, unsigned& year, unsigned& month, unsigned& day) {
+  days += 719468;
+  unsigned era = days / 146097;
+  unsigned doe = days - era * 146097;
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  day = doy - (153 * mp + 2) / 5 + 1;
+  month = mp < 10 ? mp + 3 : mp - 9;
+  year = yoe + era * 400 + (month <= 2);
+}
+
+static bool readFixed(const char*& p, unsigned digits, unsigned& out) {
+  out = 0;
+  for (unsigned i = 0; i < digits; ++i) {
+    if (!isDigit(*p)) return false;
+    out = out * 10 + static_cast<unsigned>(*p++ - '0');
+  }
+  return true;
+}
+
+static bool readHourMinute(const char*& p, unsigned& hour, unsigned& minute) {
+  const char* end = p + strlen(p);
+  if (!readNumber(p, end, 2, hour) || *p++ != ':') return false;
+  return readFixed(p, 2, minute) && hour < 24 && minute < 60;
+}
+
+const char* parseLocalTimeSchedule(const char* text, Schedule& out) {
+  const char* p = text;
+  unsigned year = 0;
+  unsigned month = 0;
+  unsigned day = 0;
+  unsigned hour = 0;
+  unsigned minute = 0;
+  bool dated = strlen(text) > 5 && text[4] == '-';
+  if (dated) {
+    if (!readFixed(p, 4, year) || *p++ != '-' || !readFixed(p, 2, month) || *p++ != '-' ||
+        !readFixed(p, 2, day) || (*p != 'T' && *p != ' ')) {
+      return "Expected HH:MM or YYYY-MM-DDTHH:MM";
+    }
+    p++;
+    if (year < static_cast<unsigned>(kMinYear) || year > static_cast<unsigned>(kMaxYear)) {
+      return "Year out of range";
+    }
+    if (month < 1 || month > 12 || day < 1 || day > daysInMonth(year, month)) return "Invalid date";
+  }
+  if (!readHourMinute(p, hour, minute) || *p != '\0') return "Expected HH:MM or YYYY-MM-DDTHH:MM";
+
+  out = Schedule();
+  if (dated) {
+    out.kind = ScheduleKind::Date;
+    out.at = daysFromCivil(year, month, day) * 86400UL + hour * 3600UL + minute * 60UL;
+  } else {
+    out.kind = ScheduleKind::Once;
+    out.days = kAllDays;
+    out.hours = 1UL << hour;
+    out.minutes = 1ULL << minute;
+  }
+  return nullptr;
+}
+
+uint32_t nextFireUtc(const Schedule& schedule, uint32_t afterUtc, long utcOffsetSeconds) {
+  if (schedule.kind == ScheduleKind::Date) {
+    return static_cast<uint32_t>(static_cast<int64_t>(schedule.at) - utcOffsetSeconds);
+  }
+  // Start at the first whole local minute after `afterUtc` and take the
+  // lowest set bit at each level: this minute's hour, later today, or the
+  // next allowed weekday. Masks are never empty, so each step is O(1).
+  int64_t start = (static_cast<int64_t>(afterUtc) + utcOffsetSeconds) / 60 * 60 + 60;
+  uint32_t day = static_cast<uint32_t>(start / 86400);
+  unsigned hour = static_cast<unsigned>(start % 86400 / 3600);
+  unsigned minute = static_cast<unsigned>(start % 3600 / 60);
+  unsigned weekday = (day + 4) % 7;  // 1970-01-01 was a Thursday
+  unsigned firstHour = __builtin_ctzl(schedule.hours);
+  unsigned firstMinute = __builtin_ctzll(schedule.minutes);
+
+  unsigned fireHour = 0;
+  unsigned fireMinute = 0;
+  bool found = false;
+  if (schedule.days & (1U << weekday)) {
+    uint64_t laterMinutes = schedule.minutes & (~0ULL << minute);
+    uint32_t laterHours = schedule.hours & (0xFFFFFFFFUL << (hour + 1));
+    if ((schedule.hours & (1UL << hour)) && laterMinutes != 0) {
+      fireHour = hour;
+      fireMinute = __builtin_ctzll(laterMinutes);
+      found = true;
+    } else if (laterHours != 0) {
+      fireHour = __builtin_ctzl(laterHours);
+      fireMinute = firstMinute;
+      found = true;
+    }
+  }
+  if (!found) {
+    // Rotate the weekday mask so bit 0 is tomorrow.
+    unsigned shift = (weekday + 1) % 7;
+    unsigned rotated = ((schedule.days >> shift) | (schedule.days << (7 - shift))) & kAllDays;
+    day += __builtin_ctz(rotated) + 1;
+    fireHour = firstHour;
+    fireMinute = firstMinute;
+  }
+  int64_t fireLocal = static_cast<int64_t>(day) * 86400 + fireHour * 3600 + fireMinute * 60;
+  return static_cast<uint32_t>(fireLocal - utcOffsetSeconds);
+}
+
+const char* scheduleKindToString(ScheduleKind kind) {
+  switch (kind) {
+    case ScheduleKind::Relative:
+      return "relative";
+    case ScheduleKind::Once:
+      return "once";
+    case ScheduleKind::Date:
+      return "date";
+    case ScheduleKind::Recurring:
+      return "recurring";
+  }
+  return "relative";
+}
+
+static void append(char* out, size_t size, size_t& length, const char* format, ...) {
+  if (length + 1 >= size) return;
+  va_list args;
+  va_start(args, format);
+  int written = vsnprintf(out + length, size - length, format, args);
+  va_end(args);
+  if (written > 0) length += static_cast<size_t>(written);
+  if (length >= size) length = size - 1;
+}
+
+// A mask over [0, count) as "*", "*/step" or a list of values and ranges.
+static void appendCronField(char* out, size_t size, size_t& length, uint64_t mask, unsigned count) {
+  uint64_t all = count == 64 ? ~0ULL : (1ULL << count) - 1;
+  if (mask == all) {
+    append(out, size, length, "*");
+    return;
+  }
+  for (unsigned step = 2; step * 2 < count; ++step) {
+    uint64_t stepped = 0;
+    for (unsigned v = 0; v < count; v += step) stepped |= 1ULL << v;
+    if (mask == stepped) {
+      append(out, size, length, "*/%u", step);
+      return;
+    }
+  }
+  const char* separator = "";
+  for (unsigned v = 0; v < count; ++v) {
+    if (!(mask & (1ULL << v))) continue;
+    unsigned last = v;
+    while (last + 1 < count && (mask & (1ULL << (last + 1)))) last++;
+    if (last > v + 1) {
+      append(out, size, length, "%s%u-%u", separator, v, last);
+    } else if (last == v + 1) {
+      append(out, size, length, "%s%u,%u", separator, v, last);
+    } else {
+      append(out, size, length, "%s%u", separator, v);
+    }
+    separator = ",";
+    v = last;
+  }
+}
+
+size_t formatSchedule(const Schedule& schedule, char* out, size_t size) {
+  size_t length = 0;
+  if (size == 0) return 0;
+  out[0] = '\0';
+  switch (schedule.kind) {
+    case ScheduleKind::Relative:
+      break;
+    case ScheduleKind::Once:
+      append(out, size, length, "%02u:%02u", __builtin_ctzl(schedule.hours), __builtin_ctzll(schedule.minutes));
+      break;
+    case ScheduleKind::Date: {
+      unsigned year = 0;
+      unsigned month = 0;
+      unsigned day = 0;
+      civilFromDays(schedule.at / 86400UL, year, month, day);
+      unsigned secondOfDay = schedule.at % 86400UL;
+      append(out, size, length, "%04u-%02u-%02uT%02u:%02u", year, month, day, secondOfDay / 3600,
+             secondOfDay / 60 % 60);
+      break;
+    }
+    case ScheduleKind::Recurring:
+      appendCronField(out, size, length, schedule.minutes, 60);
+      append(out, size, length, " ");
+      appendCronField(out, size, length, schedule.hours, 24);
+      append(out, size, length, " * * ");
+      appendCronField(out, size, length, schedule.days, 7);
+      break;
+  }
+  return length;
+}
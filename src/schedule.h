@@ -0,0 +1,40 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// When a reminder fires, compiled once at creation into bitmasks so the next
+// fire time is a handful of mask/count-trailing-zero steps. No Arduino types:
+// this also builds on a desktop host.
+
+enum class ScheduleKind : uint8_t {
+  Relative,   // `at` minutes after creation (monotonic, ignores the wall clock)
+  Once,       // next local HH:MM, then done
+  Date,       // local date and time (`at` = local seconds since the epoch), then done
+  Recurring,  // every minute/hour/weekday matching the masks
+};
+
+struct Schedule {
+  ScheduleKind kind;
+  uint8_t days;      // bit d: weekday d, 0 = Sunday
+  uint32_t hours;    // bit h: hour h
+  uint64_t minutes;  // bit m: minute m
+  uint32_t at;       // Relative: delay in minutes; Date: local epoch seconds
+};
+
+Schedule relativeSchedule(uint32_t minutes);
+
+// Each returns nullptr on success or a short error message.
+// Five cron fields, "minute hour day-of-month month day-of-week", with day of
+// month and month left as "*". Fields take "*", "n", "a-b", "a,b" and "/step";
+// day of week runs 0-7 with both 0 and 7 meaning Sunday.
+const char* parseCronSchedule(const char* text, Schedule& out);
+// "HH:MM" (the next such local time) or "YYYY-MM-DDTHH:MM" (local).
+const char* parseLocalTimeSchedule(const char* text, Schedule& out);
+
+// UTC seconds of the first fire strictly after `afterUtc`. A Date schedule
+// always returns its own time, even when that has passed. Not for Relative.
+uint32_t nextFireUtc(const Schedule& schedule, uint32_t afterUtc, long utcOffsetSeconds);
+
+const char* scheduleKindToString(ScheduleKind kind);
+// The schedule as accepted by the parsers ("" for Relative). Returns the length.
+size_t formatSchedule(const Schedule& schedule, char* out, size_t size);
@@ -0,0 +1,27 @@
+#include "state_version.h"
+
+uint32_t stateVersion = 1;
+uint32_t stateBootId = 0;
+
+static uint32_t groupVersions[kStateGroupCount] = {1, 1, 1, 1};
+
+static const char* const kStateGroupNames[] = {"face", "notes", "reminders", "info"};
+static_assert(sizeof(kStateGroupNames) / sizeof(kStateGroupNames[0]) == kStateGroupCount,
+              "kStateGroupNames must cover every StateGroup");
+
+void initStateVersion() {
+  stateBootId = esp_random();
+}
+
+void bumpState(StateGroup group) {
+  stateVersion++;
+  groupVersions[static_cast<size_t>(group)] = stateVersion;
+}
+
+bool stateChangedSince(StateGroup group, uint32_t version) {
+  return groupVersions[static_cast<size_t>(group)] > version;
+}
+
+const char* stateGroupToString(StateGroup group) {
+  return kStateGroupNames[static_cast<size_t>(group)];
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <Arduino.h>
+
+// Groups of /status fields that change together. Each mutation bumps the
+// global version and stamps its group with it, so a client holding version N
+// can be sent just the groups stamped after N.
+enum class StateGroup : uint8_t {
+  Face,       // emotion, display mode, speech
+  Notes,
+  Reminders,
+  Info,       // location, unit, weather and timezone
+};
+
+static constexpr size_t kStateGroupCount = static_cast<size_t>(StateGroup::Info) + 1;
+
+// Versions restart at 1 after a reboot; stateBootId tells clients when that happened.
+extern uint32_t stateVersion;
+extern uint32_t stateBootId;
+
+void initStateVersion();
+void bumpState(StateGroup group);
+bool stateChangedSince(StateGroup group, uint32_t version);
+const char* stateGroupToString(StateGroup group);
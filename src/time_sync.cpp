@@ -4,6 +4,7 @@
 volatile bool sntpCallbackFired = false;
 volatile uint32_t sntpEpochAtSync = 0;   // UTC epoch at last sync (uint32_t = atomic read on ESP32, valid until 2106)
 volatile uint32_t sntpMillisAtSync = 0;  // millis() captured at same instant
+volatile uint32_t sntpSyncCount = 0;
 bool ntpSynced = false;
 
 void onSntpSync(struct timeval* tv) {
@@ -11,6 +12,7 @@ void onSntpSync(struct timeval* tv) {
   sntpMillisAtSync = (uint32_t)millis();
   sntpCallbackFired = true;
   ntpSynced = true;
+  sntpSyncCount = sntpSyncCount + 1;
   Serial.printf("SNTP sync: epoch %lu\n", (unsigned long)tv->tv_sec);
 }
 
@@ -25,21 +27,45 @@ void initNtp() {
   Serial.println(ntpSynced ? "NTP synced." : "NTP sync timed out.");
 }
 
-String getLocalTimeString() {
-  if (!infoTimeValid || !sntpCallbackFired) return "--:--";
+bool getWallClock(uint32_t& utcNow, long& utcOffsetSeconds) {
+  if (!infoTimeValid || !sntpCallbackFired) return false;
   // Use the epoch captured atomically in the SNTP callback, advanced by elapsed millis.
   // This avoids time(NULL) which can oscillate while the SNTP task makes step corrections.
   // uint32_t reads/writes are atomic on the 32-bit ESP32 CPU, so no race condition.
-  uint32_t utcNow = sntpEpochAtSync + (millis() - sntpMillisAtSync) / 1000UL;
-  if (utcNow < 1000000000UL) return "--:--";  // sanity check: before year 2001
-  long secsInDay = (long)(utcNow % 86400UL) + infoUtcOffsetSeconds;
+  utcNow = sntpEpochAtSync + (millis() - sntpMillisAtSync) / 1000UL;
+  if (utcNow < 1000000000UL) return false;  // sanity check: before year 2001
+  utcOffsetSeconds = infoUtcOffsetSeconds;
+  return true;
+}
+
+bool getLocalTimeParts(int& hour12, int& minute, bool& pm) {
+  uint32_t utcNow = 0;
+  long utcOffsetSeconds = 0;
+  if (!getWallClock(utcNow, utcOffsetSeconds)) return false;
+  long secsInDay = (long)(utcNow % 86400UL) + utcOffsetSeconds;
   secsInDay = ((secsInDay % 86400L) + 86400L) % 86400L;  // normalize to [0, 86400)
   int h = (int)(secsInDay / 3600L);
-  int m = (int)((secsInDay % 3600L) / 60L);
-  bool pm = h >= 12;
+  minute = (int)((secsInDay % 3600L) / 60L);
+  pm = h >= 12;
   if (h == 0) h = 12;
   else if (h > 12) h -= 12;
-  char buf[10];
-  snprintf(buf, sizeof(buf), "%d:%02d%s", h, m, pm ? "P" : "A");
+  hour12 = h;
+  return true;
+}
+
+void getLocalTimeString(char* out, size_t size) {
+  int h = 0;
+  int m = 0;
+  bool pm = false;
+  if (!getLocalTimeParts(h, m, pm)) {
+    snprintf(out, size, "--:--");
+    return;
+  }
+  snprintf(out, size, "%d:%02d%s", h, m, pm ? "P" : "A");
+}
+
+String getLocalTimeString() {
+  char buf[kLocalTimeStringBytes];
+  getLocalTimeString(buf, sizeof(buf));
   return String(buf);
 }
@@ -5,8 +5,17 @@
 extern volatile bool sntpCallbackFired;
 extern volatile uint32_t sntpEpochAtSync;
 extern volatile uint32_t sntpMillisAtSync;
+// Bumped by every SNTP sync; wall-clock reminders re-arm when it changes.
+extern volatile uint32_t sntpSyncCount;
 extern bool ntpSynced;
 
 void onSntpSync(struct timeval* tv);
 void initNtp();
+// UTC seconds and the local offset; returns false until NTP and the UTC offset are known.
+bool getWallClock(uint32_t& utcNow, long& utcOffsetSeconds);
+// Local 12-hour clock; returns false until NTP and the UTC offset are known.
+bool getLocalTimeParts(int& hour12, int& minute, bool& pm);
+// "h:mmA" / "h:mmP", or "--:--" before the clock is known.
+static constexpr size_t kLocalTimeStringBytes = 8;
+void getLocalTimeString(char* out, size_t size);
 String getLocalTimeString();
@@ -2,14 +2,8 @@
 #include <Arduino.h>
 
 enum class Emotion { Neutral, Happy, Sad, Sleepy, Angry, Surprised, Thinking, Love };
+static constexpr size_t kEmotionCount = static_cast<size_t>(Emotion::Love) + 1;
 
 enum class DisplayMode { Face, Info };
 
-struct Reminder {
-  bool active;
-  uint32_t dueMs;
-  String message;
-};
-
-static constexpr size_t kMaxNotes = 8;
-static constexpr size_t kMaxReminders = 8;
+static constexpr size_t kMaxSpeechChars = 160;
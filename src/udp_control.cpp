@@ -0,0 +1,119 @@
+#include "udp_control.h"
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+
+uint32_t udpPacketsReceived = 0;
+uint32_t udpPacketsApplied = 0;
+uint32_t udpPacketsStale = 0;
+uint32_t udpPacketsMalformed = 0;
+
+static int controlSocket = -1;
+static bool haveLastSequence = false;
+static uint16_t lastSession = 0;
+static uint32_t lastSequence = 0;
+
+// Packets are read into this buffer in place; one spare byte exposes oversized datagrams.
+static uint8_t rxBuffer[kControlMaxPacket + 1];
+
+static uint16_t readU16(const uint8_t* p) {
+  return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t readU32(const uint8_t* p) {
+  return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+         (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+bool decodeControlPacket(const uint8_t* data, size_t length, ControlPacket& out) {
+  if (length < kControlHeaderBytes || length > kControlMaxPacket) return false;
+  if (data[0] != kControlMagic0 || data[1] != kControlMagic1 || data[2] != kControlVersion) {
+    return false;
+  }
+  out.flags = data[3];
+  if ((out.flags & ~kControlKnownFlags) != 0) return false;
+  out.session = readU16(data + 4);
+  out.sequence = readU32(data + 6);
+
+  const uint8_t* p = data + kControlHeaderBytes;
+  const uint8_t* end = data + length;
+  out.emotion = 0;
+  out.gazeX = 0;
+  out.gazeY = 0;
+  out.speechLength = 0;
+  out.speech[0] = '\0';
+
+  if (out.flags & kControlEmotion) {
+    if (end - p < 1) return false;
+    out.emotion = *p++;
+  }
+  if (out.flags & kControlGaze) {
+    if (end - p < 2) return false;
+    out.gazeX = static_cast<int8_t>(*p++);
+    out.gazeY = static_cast<int8_t>(*p++);
+  }
+  if (out.flags & kControlSpeech) {
+    if (end - p < 1) return false;
+    size_t speechLength = *p++;
+    if (speechLength > kControlMaxSpeech || static_cast<size_t>(end - p) < speechLength) return false;
+    if (memchr(p, '\0', speechLength) != nullptr) return false;
+    memcpy(out.speech, p, speechLength);
+    out.speech[speechLength] = '\0';
+    out.speechLength = static_cast<uint8_t>(speechLength);
+    p += speechLength;
+  }
+  return p == end;
+}
+
+bool acceptControlSequence(const ControlPacket& packet) {
+  // Serial-number comparison, so the sequence may wrap.
+  if (haveLastSequence && packet.session == lastSession &&
+      static_cast<int32_t>(packet.sequence - lastSequence) <= 0) {
+    return false;
+  }
+  haveLastSequence = true;
+  lastSession = packet.session;
+  lastSequence = packet.sequence;
+  return true;
+}
+
+bool beginUdpControl(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return false;
+
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+    close(fd);
+    return false;
+  }
+  controlSocket = fd;
+  return true;
+}
+
+void serviceUdpControl(ControlApplyFn apply) {
+  if (controlSocket < 0) return;
+
+  // Bounded so a flood cannot starve the rest of loop().
+  ControlPacket packet;
+  for (int i = 0; i < 16; ++i) {
+    ssize_t received = recv(controlSocket, rxBuffer, sizeof(rxBuffer), MSG_DONTWAIT);
+    if (received < 0) return;  // EAGAIN: queue drained
+
+    udpPacketsReceived++;
+    if (!decodeControlPacket(rxBuffer, static_cast<size_t>(received), packet)) {
+      udpPacketsMalformed++;
+      continue;
+    }
+    if (!acceptControlSequence(packet)) {
+      udpPacketsStale++;
+      continue;
+    }
+    udpPacketsApplied++;
+    apply(packet);
+  }
+}
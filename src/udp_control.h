@@ -0,0 +1,65 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Low-latency control over UDP for desktop tools that stream emotion, gaze and
+// speech faster than HTTP can carry them. Plain BSD sockets and no Arduino
+// types, so this file also builds on a desktop host for loopback testing.
+//
+// Packet (little-endian), one datagram each:
+//   0  'C' '3'     magic
+//   2  u8          version (kControlVersion)
+//   3  u8          flags (kControl* below); unknown bits are rejected
+//   4  u16         session, picked at random by each sender instance
+//   6  u32         sequence, incremented per packet by the sender
+//   10 [u8]        emotion index                    if kControlEmotion
+//      [i8 i8]     gaze x, y in pixels              if kControlGaze
+//      [u8 + N]    speech length and UTF-8 bytes    if kControlSpeech
+//
+// Last writer wins: a packet is applied only if its sequence is newer than the
+// last one applied from the same session, so reordered or duplicated datagrams
+// are dropped. A packet from a different session takes over immediately, which
+// lets a restarted sender (or a second tool) win without waiting.
+
+static constexpr uint8_t kControlMagic0 = 'C';
+static constexpr uint8_t kControlMagic1 = '3';
+static constexpr uint8_t kControlVersion = 1;
+static constexpr size_t kControlHeaderBytes = 10;
+static constexpr size_t kControlMaxSpeech = 160;
+static constexpr size_t kControlMaxPacket = kControlHeaderBytes + 1 + 2 + 1 + kControlMaxSpeech;
+
+static constexpr uint8_t kControlEmotion = 0x01;
+static constexpr uint8_t kControlGaze = 0x02;
+static constexpr uint8_t kControlSpeech = 0x04;
+static constexpr uint8_t kControlGazeRelease = 0x08;  // hand the eyes back to the idle animation
+static constexpr uint8_t kControlKnownFlags =
+    kControlEmotion | kControlGaze | kControlSpeech | kControlGazeRelease;
+
+struct ControlPacket {
+  uint8_t flags;
+  uint16_t session;
+  uint32_t sequence;
+  uint8_t emotion;
+  int8_t gazeX;
+  int8_t gazeY;
+  uint8_t speechLength;
+  char speech[kControlMaxSpeech + 1];  // NUL-terminated
+};
+
+// Parses one datagram; false if it is malformed in any way.
+bool decodeControlPacket(const uint8_t* data, size_t length, ControlPacket& out);
+
+// True if `packet` is newer than the last accepted one (and records it).
+bool acceptControlSequence(const ControlPacket& packet);
+
+typedef void (*ControlApplyFn)(const ControlPacket& packet);
+
+// Binds a UDP socket on `port`; false if the socket could not be opened.
+bool beginUdpControl(uint16_t port);
+// Drains queued datagrams, calling `apply` for each accepted packet in arrival order.
+void serviceUdpControl(ControlApplyFn apply);
+
+extern uint32_t udpPacketsReceived;
+extern uint32_t udpPacketsApplied;
+extern uint32_t udpPacketsStale;
+extern uint32_t udpPacketsMalformed;
@@ -0,0 +1,402 @@
+#include "wal.h"
+#include <string.h>
+#ifndef ARDUINO
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+WalStats walStats = {};
+
+static const char kLogName[] = "state.log";
+static const char kTempName[] = "state.tmp";
+static const uint8_t kHeader[] = {'C', '3', 'W', 'L', 1};
+static constexpr size_t kFrameBytes = 4;  // type, length, CRC
+
+static WalBackend* storage = nullptr;
+// Pending records, or the snapshot being written during walCompact().
+static uint8_t buffer[kWalBufferBytes];
+static size_t buffered = 0;
+static bool snapshotting = false;
+static bool snapshotFailed = false;
+static uint32_t snapshotWritten = 0;
+// A failed append may have left a partial record; only a compaction repairs that.
+static bool needsRewrite = false;
+
+static uint16_t crc16(const uint8_t* data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; ++i) {
+    crc ^= static_cast<uint16_t>(data[i]) << 8;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+  }
+  return crc;
+}
+
+static void frameRecord(uint8_t type, const uint8_t* payload, size_t length) {
+  uint8_t* record = buffer + buffered;
+  record[0] = type;
+  record[1] = static_cast<uint8_t>(length);
+  memcpy(record + 2, payload, length);
+  uint16_t crc = crc16(record, length + 2);
+  record[length + 2] = static_cast<uint8_t>(crc);
+  record[length + 3] = static_cast<uint8_t>(crc >> 8);
+  buffered += length + kFrameBytes;
+}
+
+static bool appendTo(const char* name, const uint8_t* data, size_t length) {
+  if (!storage->append(name, data, length)) {
+    walStats.failedWrites++;
+    return false;
+  }
+  walStats.bytesWritten += length;
+  return true;
+}
+
+static bool replay(WalApplyFn apply) {
+  walStats.logBytes = 0;
+  walStats.replayRecords = 0;
+  walStats.tornTail = false;
+  if (!storage->beginRead(kLogName)) return true;  // first boot
+
+  size_t have = 0;
+  uint32_t valid = 0;
+  bool headerSeen = false;
+  bool damaged = false;
+  while (!damaged) {
+    size_t got = storage->read(buffer + have, sizeof(buffer) - have);
+    have += got;
+    size_t pos = 0;
+    if (!headerSeen && have >= sizeof(kHeader)) {
+      if (memcmp(buffer, kHeader, sizeof(kHeader)) != 0) {
+        damaged = true;
+        break;
+      }
+      headerSeen = true;
+      pos = sizeof(kHeader);
+    }
+    while (headerSeen && have - pos >= kFrameBytes) {
+      size_t length = buffer[pos + 1];
+      size_t total = length + kFrameBytes;
+      if (have - pos < total) break;
+      uint16_t crc = static_cast<uint16_t>(buffer[pos + total - 2] | (buffer[pos + total - 1] << 8));
+      if (crc16(buffer + pos, length + 2) != crc) {
+        damaged = true;
+        break;
+      }
+      apply(buffer[pos], buffer + pos + 2, length);
+      walStats.replayRecords++;
+      pos += total;
+    }
+    valid += pos;
+    memmove(buffer, buffer + pos, have - pos);
+    have -= pos;
+    if (got == 0) {
+      damaged = damaged || have > 0;  // a record cut short by a reset
+      break;
+    }
+  }
+  storage->endRead();
+  walStats.logBytes = valid;
+  walStats.tornTail = damaged;
+  return true;
+}
+
+bool walOpen(WalBackend& backend, WalApplyFn apply, WalSnapshotFn snapshot) {
+  storage = &backend;
+  buffered = 0;
+  if (!storage->begin()) return false;
+  // Builds that removed state.log before renaming could be reset in between,
+  // leaving only the finished snapshot; adopt it rather than start empty.
+  if (storage->beginRead(kLogName)) {
+    storage->endRead();
+  } else {
+    storage->replace(kTempName, kLogName);
+  }
+  replay(apply);
+  buffered = 0;
+  walStats.snapshotBytes = walStats.logBytes;
+  if (walStats.tornTail) return walCompact(snapshot);
+  return true;
+}
+
+bool walAppend(uint8_t type, const uint8_t* payload, size_t length) {
+  if (storage == nullptr || snapshotting || length > kWalMaxPayload) return false;
+  if (buffered + length + kFrameBytes > sizeof(buffer) && !walFlush()) return false;
+  frameRecord(type, payload, length);
+  return true;
+}
+
+size_t walPendingBytes() {
+  return buffered;
+}
+
+bool walFlush() {
+  if (storage == nullptr || buffered == 0) return true;
+  walStats.flushes++;
+  bool ok = true;
+  if (walStats.logBytes == 0) {
+    ok = appendTo(kLogName, kHeader, sizeof(kHeader));
+    if (ok) walStats.logBytes = sizeof(kHeader);
+  }
+  if (ok) ok = appendTo(kLogName, buffer, buffered);
+  if (ok) {
+    walStats.logBytes += buffered;
+  } else {
+    needsRewrite = true;
+  }
+  // Dropped on failure too: the state is still in RAM and the rewrite restores it.
+  buffered = 0;
+  return ok;
+}
+
+static void flushSnapshot() {
+  if (buffered == 0) return;
+  if (snapshotFailed) {
+    // Keep going without writing; walCompact reports the failure.
+  } else if (appendTo(kTempName, buffer, buffered)) {
+    snapshotWritten += buffered;
+  } else {
+    snapshotFailed = true;
+  }
+  buffered = 0;
+}
+
+bool walSnapshotRecord(uint8_t type, const uint8_t* payload, size_t length) {
+  if (!snapshotting || length > kWalMaxPayload) return false;
+  if (buffered + length + kFrameBytes > sizeof(buffer)) flushSnapshot();
+  frameRecord(type, payload, length);
+  return !snapshotFailed;
+}
+
+bool walCompact(WalSnapshotFn snapshot) {
+  if (storage == nullptr) return false;
+  // Whatever is pending is already in RAM state, so the snapshot covers it.
+  buffered = 0;
+  storage->remove(kTempName);
+  snapshotting = true;
+  snapshotFailed = false;
+  snapshotWritten = 0;
+  memcpy(buffer, kHeader, sizeof(kHeader));
+  buffered = sizeof(kHeader);
+  snapshot();
+  flushSnapshot();
+  snapshotting = false;
+
+  if (snapshotFailed || !storage->replace(kTempName, kLogName)) {
+    if (!snapshotFailed) walStats.failedWrites++;
+    storage->remove(kTempName);
+    needsRewrite = true;
+    return false;
+  }
+  walStats.logBytes = snapshotWritten;
+  walStats.snapshotBytes = snapshotWritten;
+  walStats.compactions++;
+  needsRewrite = false;
+  return true;
+}
+
+bool walShouldCompact(uint32_t slackBytes) {
+  return needsRewrite || walStats.logBytes > 2 * walStats.snapshotBytes + slackBytes;
+}
+
+void WalRecordWriter::bytes(const void* source, size_t count) {
+  if (length + count > sizeof(data)) {
+    overflow = true;
+    return;
+  }
+  memcpy(data + length, source, count);
+  length += count;
+}
+
+void WalRecordWriter::u16(uint16_t value) {
+  uint8_t raw[2] = {static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8)};
+  bytes(raw, sizeof(raw));
+}
+
+void WalRecordWriter::u32(uint32_t value) {
+  u16(static_cast<uint16_t>(value));
+  u16(static_cast<uint16_t>(value >> 16));
+}
+
+void WalRecordWriter::u64(uint64_t value) {
+  u32(static_cast<uint32_t>(value));
+  u32(static_cast<uint32_t>(value >> 32));
+}
+
+void WalRecordWriter::f64(double value) {
+  uint64_t raw = 0;
+  static_assert(sizeof(raw) == sizeof(value), "double must be 64-bit");
+  memcpy(&raw, &value, sizeof(raw));
+  u64(raw);
+}
+
+void WalRecordWriter::str(const char* text, size_t maxBytes) {
+  size_t count = text != nullptr ? strlen(text) : 0;
+  if (maxBytes > 255) maxBytes = 255;
+  if (count > maxBytes) {
+    count = maxBytes;
+    // Do not leave half a UTF-8 sequence behind.
+    while (count > 0 && (static_cast<uint8_t>(text[count]) & 0xC0) == 0x80) count--;
+  }
+  u8(static_cast<uint8_t>(count));
+  bytes(text, count);
+}
+
+bool WalRecordReader::bytes(void* out, size_t count) {
+  if (!ok || offset + count > length) {
+    ok = false;
+    memset(out, 0, count);
+    return false;
+  }
+  memcpy(out, data + offset, count);
+  offset += count;
+  return true;
+}
+
+uint8_t WalRecordReader::u8() {
+  uint8_t value = 0;
+  bytes(&value, 1);
+  return value;
+}
+
+uint16_t WalRecordReader::u16() {
+  uint8_t raw[2];
+  bytes(raw, sizeof(raw));
+  return static_cast<uint16_t>(raw[0] | (raw[1] << 8));
+}
+
+uint32_t WalRecordReader::u32() {
+  uint32_t low = u16();
+  return low | (static_cast<uint32_t>(u16()) << 16);
+}
+
+uint64_t WalRecordReader::u64() {
+  uint64_t low = u32();
+  return low | (static_cast<uint64_t>(u32()) << 32);
+}
+
+double WalRecordReader::f64() {
+  uint64_t raw = u64();
+  double value = 0;
+  memcpy(&value, &raw, sizeof(value));
+  return value;
+}
+
+void WalRecordReader::str(char* out, size_t size) {
+  size_t count = u8();
+  if (!ok || offset + count > length) {
+    ok = false;
+    out[0] = '\0';
+    return;
+  }
+  size_t kept = count < size - 1 ? count : size - 1;
+  while (kept > 0 && kept < count && (data[offset + kept] & 0xC0) == 0x80) kept--;
+  memcpy(out, data + offset, kept);
+  out[kept] = '\0';
+  offset += count;
+}
+
+#ifdef ARDUINO
+
+static void littleFsPath(const char* name, char* out, size_t size) {
+  snprintf(out, size, "/%s", name);
+}
+
+bool LittleFsWalBackend::begin() {
+  return LittleFS.begin(true);  // formats an empty partition on first use
+}
+
+bool LittleFsWalBackend::beginRead(const char* name) {
+  char path[32];
+  littleFsPath(name, path, sizeof(path));
+  if (!LittleFS.exists(path)) return false;
+  reading = LittleFS.open(path, "r");
+  return static_cast<bool>(reading);
+}
+
+size_t LittleFsWalBackend::read(uint8_t* out, size_t length) {
+  return reading ? reading.read(out, length) : 0;
+}
+
+void LittleFsWalBackend::endRead() {
+  if (reading) reading.close();
+}
+
+bool LittleFsWalBackend::append(const char* name, const uint8_t* data, size_t length) {
+  char path[32];
+  littleFsPath(name, path, sizeof(path));
+  File file = LittleFS.open(path, "a");
+  if (!file) return false;
+  size_t written = file.write(data, length);
+  file.close();  // commits the write
+  return written == length;
+}
+
+bool LittleFsWalBackend::replace(const char* from, const char* to) {
+  char fromPath[32];
+  char toPath[32];
+  littleFsPath(from, fromPath, sizeof(fromPath));
+  littleFsPath(to, toPath, sizeof(toPath));
+  // esp_littlefs renames over an existing file in one metadata commit.
+  return LittleFS.rename(fromPath, toPath);
+}
+
+bool LittleFsWalBackend::remove(const char* name) {
+  char path[32];
+  littleFsPath(name, path, sizeof(path));
+  return LittleFS.exists(path) && LittleFS.remove(path);
+}
+
+#else
+
+void PosixWalBackend::pathFor(const char* name, char* out, size_t size) const {
+  snprintf(out, size, "%s/%s", directory, name);
+}
+
+bool PosixWalBackend::begin() {
+  mkdir(directory, 0755);
+  struct stat info;
+  return stat(directory, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+bool PosixWalBackend::beginRead(const char* name) {
+  char path[512];
+  pathFor(name, path, sizeof(path));
+  reading = fopen(path, "rb");
+  return reading != nullptr;
+}
+
+size_t PosixWalBackend::read(uint8_t* out, size_t length) {
+  return reading != nullptr ? fread(out, 1, length, reading) : 0;
+}
+
+void PosixWalBackend::endRead() {
+  if (reading != nullptr) fclose(reading);
+  reading = nullptr;
+}
+
+bool PosixWalBackend::append(const char* name, const uint8_t* data, size_t length) {
+  char path[512];
+  pathFor(name, path, sizeof(path));
+  FILE* file = fopen(path, "ab");
+  if (file == nullptr) return false;
+  bool ok = fwrite(data, 1, length, file) == length && fflush(file) == 0 && fsync(fileno(file)) == 0;
+  return fclose(file) == 0 && ok;
+}
+
+bool PosixWalBackend::replace(const char* from, const char* to) {
+  char fromPath[512];
+  char toPath[512];
+  pathFor(from, fromPath, sizeof(fromPath));
+  pathFor(to, toPath, sizeof(toPath));
+  return rename(fromPath, toPath) == 0;
+}
+
+bool PosixWalBackend::remove(const char* name) {
+  char path[512];
+  pathFor(name, path, sizeof(path));
+  return ::remove(path) == 0;
+}
+
+#endif
@@ -0,0 +1,136 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#ifdef ARDUINO
+#include <LittleFS.h>
+#endif
+
+// Append-only write-ahead log of small binary records, used to persist state
+// across reboots. No Arduino types outside the LittleFS backend: the engine
+// and the POSIX backend also build on a desktop host.
+//
+// File layout: "C3WL" + u8 version, then records of
+//   u8 type, u8 length, `length` payload bytes, u16 CRC-16/CCITT over all three
+// Records are buffered in RAM and written in one append per walFlush(), so a
+// burst of mutations costs one flash write. Replay stops at the first record
+// that fails its CRC (a write torn by a reset) and the log is rewritten.
+
+static constexpr size_t kWalMaxPayload = 255;
+static constexpr size_t kWalBufferBytes = 1024;
+
+// Storage for the log; swap in a different one for tests or another medium.
+class WalBackend {
+ public:
+  virtual ~WalBackend() {}
+  virtual bool begin() = 0;
+  // Sequential read of a whole file; beginRead is false if it does not exist.
+  virtual bool beginRead(const char* name) = 0;
+  virtual size_t read(uint8_t* out, size_t length) = 0;
+  virtual void endRead() = 0;
+  virtual bool append(const char* name, const uint8_t* data, size_t length) = 0;
+  // Atomically replaces `to` with `from`: a reset leaves one or the other,
+  // never neither. False (and nothing changed) if `from` does not exist.
+  virtual bool replace(const char* from, const char* to) = 0;
+  virtual bool remove(const char* name) = 0;
+};
+
+#ifdef ARDUINO
+class LittleFsWalBackend : public WalBackend {
+ public:
+  bool begin() override;
+  bool beginRead(const char* name) override;
+  size_t read(uint8_t* out, size_t length) override;
+  void endRead() override;
+  bool append(const char* name, const uint8_t* data, size_t length) override;
+  bool replace(const char* from, const char* to) override;
+  bool remove(const char* name) override;
+
+ private:
+  File reading;
+};
+#else
+// Files in a host directory, for exercising the log without a device.
+class PosixWalBackend : public WalBackend {
+ public:
+  explicit PosixWalBackend(const char* path) : directory(path) {}
+  bool begin() override;
+  bool beginRead(const char* name) override;
+  size_t read(uint8_t* out, size_t length) override;
+  void endRead() override;
+  bool append(const char* name, const uint8_t* data, size_t length) override;
+  bool replace(const char* from, const char* to) override;
+  bool remove(const char* name) override;
+
+ private:
+  void pathFor(const char* name, char* out, size_t size) const;
+
+  const char* directory;
+  FILE* reading = nullptr;
+};
+#endif
+
+struct WalStats {
+  uint32_t logBytes;       // current log size
+  uint32_t snapshotBytes;  // size right after the last compaction
+  uint32_t bytesWritten;   // since boot, compactions included
+  uint32_t flushes;
+  uint32_t compactions;
+  uint32_t failedWrites;
+  uint32_t replayRecords;
+  bool tornTail;  // the last replay discarded a damaged tail
+};
+
+extern WalStats walStats;
+
+typedef void (*WalApplyFn)(uint8_t type, const uint8_t* payload, size_t length);
+// Writes the complete current state with walSnapshotRecord().
+typedef void (*WalSnapshotFn)();
+
+// Replays the log through `apply`, then compacts it straight away if the tail
+// was damaged so later appends are not stranded behind it.
+bool walOpen(WalBackend& backend, WalApplyFn apply, WalSnapshotFn snapshot);
+// Buffers a record, flushing first if it would not fit; false if it is too
+// long or the flush failed.
+bool walAppend(uint8_t type, const uint8_t* payload, size_t length);
+size_t walPendingBytes();
+bool walFlush();
+// Rewrites the log as a snapshot of the current state, then swaps it in.
+bool walCompact(WalSnapshotFn snapshot);
+// Only valid inside a WalSnapshotFn.
+bool walSnapshotRecord(uint8_t type, const uint8_t* payload, size_t length);
+// True once the log has grown well past its last snapshot.
+bool walShouldCompact(uint32_t slackBytes);
+
+// Little-endian record payload builder and bounds-checked reader.
+struct WalRecordWriter {
+  uint8_t data[kWalMaxPayload];
+  size_t length = 0;
+  bool overflow = false;
+
+  void bytes(const void* source, size_t count);
+  void u8(uint8_t value) { bytes(&value, 1); }
+  void u16(uint16_t value);
+  void u32(uint32_t value);
+  void u64(uint64_t value);
+  void f64(double value);
+  // u8 length + bytes, cut to `maxBytes` on a UTF-8 boundary.
+  void str(const char* text, size_t maxBytes);
+};
+
+struct WalRecordReader {
+  const uint8_t* data;
+  size_t length;
+  size_t offset = 0;
+  bool ok = true;
+
+  WalRecordReader(const uint8_t* payload, size_t size) : data(payload), length(size) {}
+  bool bytes(void* out, size_t count);
+  uint8_t u8();
+  uint16_t u16();
+  uint32_t u32();
+  uint64_t u64();
+  double f64();
+  // Copies a str() field into `out` (NUL-terminated, truncated to `size` - 1).
+  void str(char* out, size_t size);
+};
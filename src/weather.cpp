@@ -1,9 +1,12 @@
 #include "weather.h"
 #include "utils.h"
+#include "events.h"
+#include "state_version.h"
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <WiFiClientSecure.h>
 #include <WiFi.h>
+#include <atomic>
 
 String infoTemperature = "Loading...";
 int infoWeatherCode = -1;
@@ -19,74 +22,206 @@ bool infoTimeValid = false;
 
 int debugLastWeatherCode = -1;
 String debugLastWeatherPayload = "";
+uint32_t infoDataRevision = 0;
 
 String infoTempUnitLabel() {
   return infoUseFahrenheit ? "F" : "C";
 }
 
-bool fetchInfoTemperature() {
-  if (WiFi.status() != WL_CONNECTED) return false;
-  if (!infoHasCoordinates) return false;
+// Settings snapshot handed to the fetch task.
+struct WeatherRequest {
+  uint32_t generation;
+  double latitude;
+  double longitude;
+  bool fahrenheit;
+};
 
-  debugLastWeatherCode = -1;
-  debugLastWeatherPayload = "";
+// Everything the fetch produced, applied to the info* globals by loop().
+struct WeatherResult {
+  uint32_t generation;
+  int httpCode;
+  bool ok;
+  bool fahrenheit;
+  float temperature;
+  int weatherCode;
+  bool hasUtcOffset;
+  long utcOffsetSeconds;
+  bool hasTimezoneAbbr;
+  String timezoneAbbr;
+  String debugPayload;
+  uint32_t durationMs;
+};
+
+uint32_t weatherFetchCount = 0;
+uint32_t weatherLastFetchDurationMs = 0;
+uint32_t weatherStaleResults = 0;
+
+// Single-slot mailboxes. The writer fills the slot and then releases the
+// flag; the reader acquires the flag, copies the slot out and clears it.
+// At most one request is outstanding, so neither slot is ever overwritten
+// while the other side reads it.
+static WeatherRequest requestSlot;
+static std::atomic<bool> requestReady(false);
+static WeatherResult resultSlot;
+static std::atomic<bool> resultReady(false);
+
+static TaskHandle_t weatherTask = nullptr;
+// Bumped when the location or unit changes, so in-flight results are dropped.
+static uint32_t weatherGeneration = 1;
+static bool fetchInFlight = false;
+
+// Runs on the fetch task: TLS handshake, GET and JSON parse.
+static void fetchWeather(const WeatherRequest& request, WeatherResult& result) {
+  result.generation = request.generation;
+  result.httpCode = -1;
+  result.ok = false;
+  result.fahrenheit = request.fahrenheit;
+  result.weatherCode = -1;
+  result.hasUtcOffset = false;
+  result.hasTimezoneAbbr = false;
+  result.timezoneAbbr = "";
+  result.debugPayload = "";
 
   WiFiClientSecure client;
   client.setInsecure();
   HTTPClient http;
-  String url = "https://api.open-meteo.com/v1/forecast?latitude=" + String(infoLatitude, 4) +
-               "&longitude=" + String(infoLongitude, 4) +
+  String url = "https://api.open-meteo.com/v1/forecast?latitude=" + String(request.latitude, 4) +
+               "&longitude=" + String(request.longitude, 4) +
                "&current=temperature_2m,weather_code&temperature_unit=" +
-               String(infoUseFahrenheit ? "fahrenheit" : "celsius") +
+               String(request.fahrenheit ? "fahrenheit" : "celsius") +
                "&timezone=auto";
-  if (!http.begin(client, url)) return false;
-  debugLastWeatherCode = http.GET();
-  if (debugLastWeatherCode != 200) {
-    debugLastWeatherPayload = truncateForDebug(http.getString());
+  if (!http.begin(client, url)) return;
+  result.httpCode = http.GET();
+  if (result.httpCode != 200) {
+    result.debugPayload = truncateForDebug(http.getString());
     http.end();
-    return false;
+    return;
   }
   String payload = http.getString();
-  debugLastWeatherPayload = truncateForDebug(payload);
+  result.debugPayload = truncateForDebug(payload);
   http.end();
 
   JsonDocument doc;
-  if (deserializeJson(doc, payload)) return false;
+  if (deserializeJson(doc, payload)) return;
   if (!doc["current"]["temperature_2m"].is<float>() && !doc["current"]["temperature_2m"].is<double>()) {
-    return false;
+    return;
   }
 
-  float tempValue = doc["current"]["temperature_2m"].as<float>();
-  String unit = infoTempUnitLabel();
+  result.temperature = doc["current"]["temperature_2m"].as<float>();
   if (doc["current"]["weather_code"].is<int>()) {
-    infoWeatherCode = doc["current"]["weather_code"].as<int>();
-  } else {
-    infoWeatherCode = -1;
+    result.weatherCode = doc["current"]["weather_code"].as<int>();
   }
-
   if (!doc["utc_offset_seconds"].isNull()) {
-    long offset = doc["utc_offset_seconds"].as<long>();
+    result.hasUtcOffset = true;
+    result.utcOffsetSeconds = doc["utc_offset_seconds"].as<long>();
+  }
+  if (!doc["timezone_abbreviation"].isNull()) {
+    result.hasTimezoneAbbr = true;
+    result.timezoneAbbr = doc["timezone_abbreviation"].as<String>();
+  }
+  result.ok = true;
+}
+
+static void weatherFetchTask(void*) {
+  WeatherRequest request;
+  WeatherResult result;
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    if (!requestReady.load(std::memory_order_acquire)) continue;
+    request = requestSlot;
+    requestReady.store(false, std::memory_order_release);
+
+    uint32_t started = millis();
+    fetchWeather(request, result);
+    result.durationMs = millis() - started;
+
+    // loop() empties the slot every pass; this only waits if it is mid-read.
+    while (resultReady.load(std::memory_order_acquire)) {
+      vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    resultSlot = result;
+    resultReady.store(true, std::memory_order_release);
+  }
+}
+
+static bool takeWeatherResult(WeatherResult& out) {
+  if (!resultReady.load(std::memory_order_acquire)) return false;
+  out = resultSlot;
+  resultSlot.timezoneAbbr = "";
+  resultSlot.debugPayload = "";
+  resultReady.store(false, std::memory_order_release);
+  return true;
+}
+
+static void applyWeatherResult(const WeatherResult& result) {
+  weatherLastFetchDurationMs = result.durationMs;
+  debugLastWeatherCode = result.httpCode;
+  debugLastWeatherPayload = result.debugPayload;
+  if (!result.ok) return;
+
+  infoWeatherCode = result.weatherCode;
+  if (result.hasUtcOffset) {
+    long offset = result.utcOffsetSeconds;
     if (offset >= -50400L && offset <= 50400L) {  // valid UTC-14 to UTC+14
       infoUtcOffsetSeconds = offset;
       infoTimeValid = true;
       Serial.printf("UTC offset set: %ld s\n", offset);
     }
   }
-  if (!doc["timezone_abbreviation"].isNull()) {
-    infoTimezoneAbbr = doc["timezone_abbreviation"].as<String>();
+  if (result.hasTimezoneAbbr) {
+    infoTimezoneAbbr = result.timezoneAbbr;
   }
 
-  infoTemperature = String(tempValue, 1) + String(" ") + unit;
+  infoTemperature = String(result.temperature, 1) + String(" ") + (result.fahrenheit ? "F" : "C");
   infoTempValid = true;
-  return true;
+  infoDataRevision++;
+  bumpState(StateGroup::Info);
+
+  if (hasEventSubscribers()) {
+    JsonDocument event;
+    event["temperature"] = infoTemperature;
+    event["weather_code"] = infoWeatherCode;
+    publishEvent("weather", event);
+  }
+}
+
+void initWeatherTask() {
+  // TLS needs a deep stack; same priority as loopTask so they time-slice.
+  xTaskCreate(weatherFetchTask, "weather", 8192, nullptr, 1, &weatherTask);
+}
+
+void requestInfoRefresh() {
+  weatherGeneration++;
+  lastInfoTempFetchMs = 0;
 }
 
 void serviceInfoData() {
-  uint32_t now = millis();
+  WeatherResult result;
+  if (takeWeatherResult(result)) {
+    fetchInFlight = false;
+    weatherFetchCount++;
+    if (result.generation == weatherGeneration) {
+      applyWeatherResult(result);
+    } else {
+      // Settings changed mid-fetch; fetch again with the new ones.
+      weatherStaleResults++;
+      lastInfoTempFetchMs = 0;
+    }
+  }
+  if (fetchInFlight) return;
 
+  uint32_t now = millis();
   uint32_t tempInterval = infoTempValid ? kInfoTempRefreshMs : kInfoRetryMs;
   if (lastInfoTempFetchMs == 0 || (now - lastInfoTempFetchMs >= tempInterval)) {
     lastInfoTempFetchMs = now;
-    fetchInfoTemperature();
+    if (WiFi.status() != WL_CONNECTED || !infoHasCoordinates) return;
+
+    requestSlot.generation = weatherGeneration;
+    requestSlot.latitude = infoLatitude;
+    requestSlot.longitude = infoLongitude;
+    requestSlot.fahrenheit = infoUseFahrenheit;
+    requestReady.store(true, std::memory_order_release);
+    fetchInFlight = true;
+    xTaskNotifyGive(weatherTask);
   }
 }
@@ -14,10 +14,21 @@ extern String infoTimezoneAbbr;
 extern bool infoTimeValid;
 extern int debugLastWeatherCode;
 extern String debugLastWeatherPayload;
+// Bumped whenever the displayed temperature or weather code changes.
+extern uint32_t infoDataRevision;
 
 static constexpr uint32_t kInfoTempRefreshMs = 10UL * 60UL * 1000UL;
 static constexpr uint32_t kInfoRetryMs = 20UL * 1000UL;
 
+// Fetch task stats.
+extern uint32_t weatherFetchCount;
+extern uint32_t weatherLastFetchDurationMs;
+extern uint32_t weatherStaleResults;
+
 String infoTempUnitLabel();
-bool fetchInfoTemperature();
+// Starts the background Open-Meteo fetch task. Call once before serviceInfoData().
+void initWeatherTask();
+// Drops any in-flight result and fetches again with the current settings.
+void requestInfoRefresh();
+// Applies a finished fetch and queues the next one; never blocks on the network.
 void serviceInfoData();
@@ -1,23 +1,43 @@
 #include "web_server.h"
+#include "enum_names.h"
 #include "display.h"
 #include "time_sync.h"
 #include "weather.h"
 #include "utils.h"
+#include "web_assets.h"
+#include "events.h"
+#include "chunked_writer.h"
+#include "json_writer.h"
+#include "json_bench.h"
+#include "power.h"
+#include "state_version.h"
+#include "perfect_hash.h"
+#include "udp_control.h"
+#include "rate_limit.h"
+#include "reminders.h"
+#include "notes.h"
+#include "persist.h"
+#include "wal.h"
 #include <WiFi.h>
+#include <detail/RequestHandler.h>
+#include <string.h>
 #include <time.h>
 
 // State owned by main.cpp
 extern Emotion currentEmotion;
 extern DisplayMode currentDisplayMode;
 extern String speechText;
-extern String notes[kMaxNotes];
-extern size_t notesCount;
-extern Reminder reminders[kMaxReminders];
+extern uint32_t loopMaxUs;
 
 // Functions defined in main.cpp
 void setEmotion(Emotion emotion);
-String emotionToString(Emotion emotion);
-bool tryParseEmotion(const String& name, Emotion& outEmotion);
+void setSpeech(const String& text);
+void setDisplayMode(DisplayMode mode);
+size_t addNote(const char* note);
+uint32_t addReminder(const Schedule& when, const String& message);
+bool cancelReminder(uint32_t id);
+bool editReminder(uint32_t id, const Schedule* when, const char* message);
+void clearNotesAndReminders();
 
 WebServer server(80);
 
@@ -25,26 +45,19 @@ WebServer server(80);
 // Helpers used only by web handlers
 // ---------------------------------------------------------------------------
 
-String currentIpAddress() {
-  return WiFi.getMode() == WIFI_AP ? WiFi.softAPIP().toString() : WiFi.localIP().toString();
+static IPAddress currentIp() {
+  return WiFi.getMode() == WIFI_AP ? WiFi.softAPIP() : WiFi.localIP();
 }
 
-String displayModeToString(DisplayMode mode) {
-  return mode == DisplayMode::Info ? "info" : "face";
+void currentIpAddress(char* out, size_t size) {
+  IPAddress ip = currentIp();
+  snprintf(out, size, "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
 }
 
-bool tryParseDisplayMode(const String& name, DisplayMode& outMode) {
-  String value = name;
-  value.toLowerCase();
-  if (value == "face") {
-    outMode = DisplayMode::Face;
-    return true;
-  }
-  if (value == "info") {
-    outMode = DisplayMode::Info;
-    return true;
-  }
-  return false;
+String currentIpAddress() {
+  char buf[kIpAddressBytes];
+  currentIpAddress(buf, sizeof(buf));
+  return String(buf);
 }
 
 bool tryParseDoubleStrict(const String& input, double& outValue) {
@@ -56,73 +69,6 @@ bool tryParseDoubleStrict(const String& input, double& outValue) {
   return endPtr != nullptr && *endPtr == '\0';
 }
 
-String tempUnitOptionsHtml() {
-  String html;
-  html += "<option value='f'";
-  if (infoUseFahrenheit) html += " selected";
-  html += ">Fahrenheit</option>";
-  html += "<option value='c'";
-  if (!infoUseFahrenheit) html += " selected";
-  html += ">Celsius</option>";
-  return html;
-}
-
-String emotionOptionsHtml(Emotion selectedEmotion) {
-  struct Item {
-    const char* name;
-    Emotion value;
-  };
-  static const Item kItems[] = {
-      {"neutral", Emotion::Neutral},       {"happy", Emotion::Happy},
-      {"sad", Emotion::Sad},               {"sleepy", Emotion::Sleepy},
-      {"angry", Emotion::Angry},           {"surprised", Emotion::Surprised},
-      {"thinking", Emotion::Thinking},     {"love", Emotion::Love},
-  };
-
-  String html;
-  for (size_t i = 0; i < sizeof(kItems) / sizeof(kItems[0]); ++i) {
-    html += "<option value='";
-    html += kItems[i].name;
-    html += "'";
-    if (kItems[i].value == selectedEmotion) {
-      html += " selected";
-    }
-    html += ">";
-    html += kItems[i].name;
-    html += "</option>";
-  }
-  return html;
-}
-
-String modeOptionsHtml(DisplayMode selectedMode) {
-  String html;
-  html += "<option value='face'";
-  if (selectedMode == DisplayMode::Face) html += " selected";
-  html += ">face</option>";
-  html += "<option value='info'";
-  if (selectedMode == DisplayMode::Info) html += " selected";
-  html += ">info</option>";
-  return html;
-}
-
-String statusMessageFromCode(const String& code) {
-  if (code == "ok_emotion") return "Emotion updated.";
-  if (code == "ok_speak") return "Speech updated.";
-  if (code == "ok_note") return "Note added.";
-  if (code == "ok_reminder") return "Reminder added.";
-  if (code == "ok_clear") return "Cleared notes and reminders.";
-  if (code == "ok_mode") return "Display mode updated.";
-  if (code == "ok_info") return "Info settings updated.";
-  if (code == "err_emotion") return "Invalid emotion.";
-  if (code == "err_speak") return "Speech text missing.";
-  if (code == "err_note") return "Note text missing.";
-  if (code == "err_reminder") return "Reminder needs minutes > 0 and message.";
-  if (code == "err_reminders_full") return "Reminder storage full.";
-  if (code == "err_mode") return "Invalid mode. Use face or info.";
-  if (code == "err_info") return "Latitude/longitude required and must be valid.";
-  return "";
-}
-
 void sendUiRedirect(const char* code) {
   String location = "/";
   if (code != nullptr && code[0] != '\0') {
@@ -148,46 +94,267 @@ bool parseJsonBody(JsonDocument& doc) {
   return !err;
 }
 
+// Streams a JSON object response: the members written to `json` go straight
+// to the socket, and the object and response are closed on destruction.
+class JsonResponse {
+ public:
+  explicit JsonResponse(int statusCode) : body(server), json(body) {
+    body.begin(statusCode, "application/json");
+    json.beginObject();
+  }
+  ~JsonResponse() {
+    json.endObject();
+    body.end();
+  }
+
+  ChunkedWriter body;  // declared first: json writes through it
+  JsonWriter json;
+};
+
+void sendOk() {
+  JsonResponse response(200);
+  response.json.field("ok", true);
+}
+
 // ---------------------------------------------------------------------------
 // HTTP handlers
 // ---------------------------------------------------------------------------
 
+// Emits the /status members into an open object. Templated over the writer so
+// the same content can be streamed (JsonWriter) or built as a JsonDocument.
+// The versioned groups come first; the few fields after them only appear in
+// full responses.
+static constexpr size_t kStatusReminders = 8;
+static constexpr size_t kStatusNotes = 8;
+static constexpr size_t kNotesPageDefault = 20;
+static constexpr size_t kNotesPageMax = 50;
+
+// GET /reminders and the mutation replies include a countdown. /status does
+// not, so its ETag need not change every second (see formatStatusEtag): it
+// says whether each reminder is armed and, for wall-clock ones, the fire time.
+static constexpr uint64_t kNoCountdown = 0;
+
+template <typename Writer>
+static void writeReminder(Writer& json, const Reminder& reminder, uint64_t now) {
+  json.beginObject();
+  json.field("id", reminder.id);
+  json.field("message", reminder.message);
+  json.field("kind", scheduleKindToString(reminder.schedule.kind));
+  if (reminder.schedule.kind != ScheduleKind::Relative) {
+    char schedule[96];
+    formatSchedule(reminder.schedule, schedule, sizeof(schedule));
+    json.field("schedule", schedule);
+  }
+  if (now == kNoCountdown) {
+    json.field("armed", reminder.dueMs != kReminderUnarmed);
+  } else if (reminder.dueMs == kReminderUnarmed) {
+    json.key("ms_remaining");
+    json.null();  // waiting for the local time to be known
+  } else {
+    // Clamped to 32 bits: ~49 days is plenty for a countdown readout.
+    uint64_t remaining = reminder.dueMs > now ? reminder.dueMs - now : 0;
+    json.field("ms_remaining", static_cast<unsigned long>(remaining > UINT32_MAX ? UINT32_MAX : remaining));
+  }
+  if (reminder.fireUtc != 0) json.field("fire_utc", static_cast<unsigned long>(reminder.fireUtc));
+  json.endObject();
+}
+
+template <typename Writer>
+static void writeStateGroupFields(Writer& json, StateGroup group) {
+  switch (group) {
+    case StateGroup::Face:
+      json.field("emotion", emotionToString(currentEmotion));
+      json.field("mode", displayModeToString(currentDisplayMode));
+      json.field("speech", speechText);
+      break;
+    case StateGroup::Notes: {
+      // Only the newest few; GET /notes pages through the rest.
+      json.beginArray("notes");
+      const Note* note = nullptr;
+      for (size_t i = 0; i < kStatusNotes && (note = noteFromNewest(i)) != nullptr; ++i) {
+        json.value(note->text);
+      }
+      json.endArray();
+      json.field("notes_total", noteCount());
+      break;
+    }
+    case StateGroup::Reminders: {
+      // Only the soonest few; GET /reminders has the full list.
+      const Reminder* soonest[kStatusReminders];
+      size_t count = remindersByDue(soonest, kStatusReminders);
+      json.beginArray("reminders");
+      for (size_t i = 0; i < count; ++i) {
+        writeReminder(json, *soonest[i], kNoCountdown);
+      }
+      json.endArray();
+      json.field("reminders_total", reminderCount());
+      break;
+    }
+    case StateGroup::Info:
+      json.field("info_temperature", infoTemperature);
+      json.field("info_temperature_unit", infoTempUnitLabel());
+      json.field("info_weather_code", infoWeatherCode);
+      json.field("info_latitude", infoLatitude);
+      json.field("info_longitude", infoLongitude);
+      json.field("info_timezone_abbr", infoTimezoneAbbr);
+      json.field("info_utc_offset_seconds", infoUtcOffsetSeconds);
+      break;
+  }
+}
+
+template <typename Writer>
+static void writeStatusFields(Writer& json) {
+  json.field("state_version", stateVersion);
+  json.field("boot_id", stateBootId);
+  for (size_t i = 0; i < kStateGroupCount; ++i) {
+    writeStateGroupFields(json, static_cast<StateGroup>(i));
+  }
+  json.field("speech_max_chars", kMaxSpeechChars);
+  // Formatted on the stack rather than into a String per poll. Passed as
+  // const char* so a JsonDocument copies them instead of keeping the pointer.
+  char ip[kIpAddressBytes];
+  currentIpAddress(ip, sizeof(ip));
+  json.field("ip", static_cast<const char*>(ip));
+  char localTime[kLocalTimeStringBytes];
+  getLocalTimeString(localTime, sizeof(localTime));
+  json.field("info_local_time", static_cast<const char*>(localTime));
+  json.field("ntp_synced", ntpSynced);
+  json.field("sntp_callback_fired", static_cast<bool>(sntpCallbackFired));
+}
+
+// GET /debug/stats: counters and timings that move on every request or loop
+// pass, kept out of /status so its ETag stays valid between state changes.
+template <typename Writer>
+static void writeDiagnostics(Writer& json) {
+  json.field("debug_time_utc_epoch", (long)time(NULL));
+  json.field("debug_weather_api_code", debugLastWeatherCode);
+  json.field("debug_weather_api_payload", debugLastWeatherPayload);
+  json.field("weather_fetch_count", weatherFetchCount);
+  json.field("weather_fetch_ms", weatherLastFetchDurationMs);
+  json.field("weather_stale_results", weatherStaleResults);
+  json.field("loop_max_us", loopMaxUs);
+  json.field("udp_packets_received", udpPacketsReceived);
+  json.field("udp_packets_applied", udpPacketsApplied);
+  json.field("udp_packets_stale", udpPacketsStale);
+  json.field("udp_packets_malformed", udpPacketsMalformed);
+  json.beginObject("rate_limit");
+  for (size_t i = 0; i < kRouteClassCount; ++i) {
+    json.beginObject(routeClassToString(static_cast<RouteClass>(i)));
+    json.field("accepted", rateAccepted[i]);
+    json.field("rejected", rateRejected[i]);
+    json.endObject();
+  }
+  json.field("rejected_global", rateRejectedGlobal);
+  json.field("clients_evicted", rateClientsEvicted);
+  json.endObject();
+  json.beginObject("persist");
+  json.field("ready", persistReady);
+  json.field("replay_us", persistReplayUs);
+  json.field("replay_records", walStats.replayRecords);
+  json.field("torn_tail", walStats.tornTail);
+  json.field("log_bytes", walStats.logBytes);
+  json.field("snapshot_bytes", walStats.snapshotBytes);
+  json.field("flushes", walStats.flushes);
+  json.field("compactions", walStats.compactions);
+  json.field("failed_writes", walStats.failedWrites);
+  json.field("bytes_written", walStats.bytesWritten);
+  // Flash wear estimate: rates since boot projected over 24 hours.
+  json.field("flushes_per_day", persistPerDay(walStats.flushes + walStats.compactions));
+  json.field("bytes_per_day", persistPerDay(walStats.bytesWritten));
+  json.endObject();
+  json.field("event_subscribers", eventSubscriberCount());
+  json.field("events_published", eventsPublished);
+  json.field("display_frames_sent", displayFramesSent);
+  json.field("display_frames_dropped", displayFramesDropped);
+  json.field("display_last_frame_bytes", displayLastFrameBytes);
+  json.field("display_avg_frame_bytes",
+             displayFramesSent > 0 ? displayBytesSentTotal / displayFramesSent : 0);
+  json.field("face_cache_hits", faceCacheHits);
+  json.field("face_cache_misses", faceCacheMisses);
+  json.field("power_profile", powerProfileToString(powerProfile));
+  json.field("power_idle_ms", powerIdleMs());
+  json.field("power_wake_count", powerWakeCount);
+  json.field("cpu_mhz", getCpuFrequencyMhz());
+  json.beginObject("power_profile_ms");
+  for (size_t i = 0; i < kPowerProfileCount; ++i) {
+    PowerProfile profile = static_cast<PowerProfile>(i);
+    json.field(powerProfileToString(profile), powerProfileMs(profile));
+  }
+  json.endObject();
+}
+
+// Everything in the full /status document is a function of the state
+// version, the local minute (info_local_time), the IP address and the two NTP
+// flags, so the ETag is built from exactly those. Reminders carry no countdown
+// there and diagnostics live in /debug/stats, so an idle poller keeps getting
+// 304 until something it can see changes.
+static void formatStatusEtag(char* out, size_t size) {
+  uint32_t utcNow = 0;
+  long utcOffsetSeconds = 0;
+  unsigned long minute = getWallClock(utcNow, utcOffsetSeconds) ? utcNow / 60UL : 0;
+  IPAddress ip = currentIp();
+  unsigned long address = (static_cast<unsigned long>(ip[0]) << 24) | (static_cast<unsigned long>(ip[1]) << 16) |
+                          (static_cast<unsigned long>(ip[2]) << 8) | ip[3];
+  unsigned flags = (ntpSynced ? 1U : 0U) | (sntpCallbackFired ? 2U : 0U);
+  snprintf(out, size, "\"%08lx-%lu-%lx-%08lx%x\"", static_cast<unsigned long>(stateBootId),
+           static_cast<unsigned long>(stateVersion), minute, address, flags);
+}
+
+// GET /status?since=N returns just the groups changed after version N, with
+// no ETag. A `since` newer than the current version (the device rebooted)
+// gets the full document instead.
 void handleStatus() {
-  JsonDocument doc;
-  doc["emotion"] = emotionToString(currentEmotion);
-  doc["mode"] = displayModeToString(currentDisplayMode);
-  doc["speech"] = speechText;
-  doc["ip"] = currentIpAddress();
-  doc["info_temperature"] = infoTemperature;
-  doc["info_temperature_unit"] = infoTempUnitLabel();
-  doc["info_weather_code"] = infoWeatherCode;
-  doc["info_latitude"] = infoLatitude;
-  doc["info_longitude"] = infoLongitude;
-  doc["info_local_time"] = getLocalTimeString();
-  doc["info_timezone_abbr"] = infoTimezoneAbbr;
-  doc["info_utc_offset_seconds"] = infoUtcOffsetSeconds;
-  doc["debug_time_utc_epoch"] = (long)time(NULL);
-  doc["ntp_synced"] = ntpSynced;
-  doc["sntp_callback_fired"] = sntpCallbackFired;
-  doc["debug_weather_api_code"] = debugLastWeatherCode;
-  doc["debug_weather_api_payload"] = debugLastWeatherPayload;
-
-  JsonArray notesArr = doc["notes"].to<JsonArray>();
-  for (size_t i = 0; i < notesCount; ++i) {
-    notesArr.add(notes[i]);
-  }
-
-  JsonArray remindersArr = doc["reminders"].to<JsonArray>();
-  uint32_t now = millis();
-  for (size_t i = 0; i < kMaxReminders; ++i) {
-    if (!reminders[i].active) continue;
-
-    JsonObject item = remindersArr.add<JsonObject>();
-    item["message"] = reminders[i].message;
-    item["ms_remaining"] = reminders[i].dueMs > now ? (reminders[i].dueMs - now) : 0;
+  server.sendHeader("Cache-Control", "no-cache");
+  if (server.hasArg("since")) {
+    String sinceArg = server.arg("since");
+    char* endPtr = nullptr;
+    unsigned long since = strtoul(sinceArg.c_str(), &endPtr, 10);
+    if (sinceArg.length() == 0 || endPtr == nullptr || *endPtr != '\0') {
+      JsonDocument error;
+      error["error"] = "Expected since=<state_version>";
+      sendJson(400, error);
+      return;
+    }
+    if (since <= stateVersion) {
+      JsonResponse response(200);
+      response.json.field("state_version", stateVersion);
+      response.json.field("boot_id", stateBootId);
+      response.json.field("since", since);
+      response.json.beginArray("changed");
+      for (size_t i = 0; i < kStateGroupCount; ++i) {
+        StateGroup group = static_cast<StateGroup>(i);
+        if (stateChangedSince(group, since)) response.json.value(stateGroupToString(group));
+      }
+      response.json.endArray();
+      for (size_t i = 0; i < kStateGroupCount; ++i) {
+        StateGroup group = static_cast<StateGroup>(i);
+        if (stateChangedSince(group, since)) writeStateGroupFields(response.json, group);
+      }
+      return;
+    }
   }
 
-  sendJson(200, doc);
+  char etag[48];
+  formatStatusEtag(etag, sizeof(etag));
+  server.sendHeader("ETag", etag);
+  if (server.header("If-None-Match") == etag) {
+    server.send(304);
+    return;
+  }
+  JsonResponse response(200);
+  writeStatusFields(response.json);
+}
+
+void handleDebugStats() {
+  server.sendHeader("Cache-Control", "no-store");
+  JsonResponse response(200);
+  writeDiagnostics(response.json);
+}
+
+template <typename Writer>
+static void writeEmotionResult(Writer& json) {
+  json.field("ok", true);
+  json.field("emotion", emotionToString(currentEmotion));
 }
 
 void handleEmotion() {
@@ -208,7 +375,7 @@ void handleEmotion() {
   }
 
   Emotion parsedEmotion = Emotion::Neutral;
-  if (!tryParseEmotion(emotionArg, parsedEmotion)) {
+  if (!tryParseEmotion(emotionArg.c_str(), parsedEmotion)) {
     JsonDocument error;
     error["error"] = "Invalid emotion";
     error["received"] = emotionArg;
@@ -218,18 +385,14 @@ void handleEmotion() {
   }
 
   setEmotion(parsedEmotion);
-  drawFace();
 
-  JsonDocument result;
-  result["ok"] = true;
-  result["emotion"] = emotionToString(currentEmotion);
-  sendJson(200, result);
+  JsonResponse response(200);
+  writeEmotionResult(response.json);
 }
 
 void handleEmotionGet() {
-  JsonDocument doc;
-  doc["emotion"] = emotionToString(currentEmotion);
-  sendJson(200, doc);
+  JsonResponse response(200);
+  response.json.field("emotion", emotionToString(currentEmotion));
 }
 
 void handleSpeak() {
@@ -247,20 +410,14 @@ void handleSpeak() {
     textArg = doc["text"].as<String>();
   }
 
-  speechText = textArg;
-  if (speechText.length() > 40) {
-    speechText = speechText.substring(0, 40);
-  }
-
-  JsonDocument result;
-  result["ok"] = true;
-  sendJson(200, result);
+  setSpeech(textArg);
+  sendOk();
 }
 
 void handleNotesAdd() {
-  String noteArg;
+  size_t count = 0;
   if (server.hasArg("note")) {
-    noteArg = server.arg("note");
+    count = addNote(server.arg("note").c_str());
   } else {
     JsonDocument doc;
     if (!parseJsonBody(doc) || !doc["note"].is<const char*>()) {
@@ -269,246 +426,391 @@ void handleNotesAdd() {
       sendJson(400, error);
       return;
     }
-    noteArg = doc["note"].as<String>();
+    count = addNote(doc["note"].as<const char*>());
   }
 
-  if (notesCount >= kMaxNotes) {
-    for (size_t i = 1; i < kMaxNotes; ++i) {
-      notes[i - 1] = notes[i];
-    }
-    notesCount = kMaxNotes - 1;
-  }
+  JsonResponse response(200);
+  response.json.field("ok", true);
+  response.json.field("count", count);
+}
 
-  notes[notesCount++] = noteArg;
+// Reads an optional unsigned query arg; false if present but not a number.
+static bool unsignedArg(const char* name, size_t fallback, size_t& out) {
+  out = fallback;
+  if (!server.hasArg(name)) return true;
+  String value = server.arg(name);
+  char* endPtr = nullptr;
+  unsigned long parsed = strtoul(value.c_str(), &endPtr, 10);
+  if (value.length() == 0 || value[0] == '-' || endPtr == nullptr || *endPtr != '\0') return false;
+  out = parsed;
+  return true;
+}
 
-  JsonDocument result;
-  result["ok"] = true;
-  result["count"] = notesCount;
-  sendJson(200, result);
+template <typename Writer>
+static void writeNotesPage(Writer& json, size_t offset, size_t limit) {
+  const Note* newest = noteFromNewest(0);
+  json.field("total", noteCount());
+  json.field("capacity", kMaxNotes);
+  json.field("offset", offset);
+  json.field("limit", limit);
+  json.field("newest_seq", newest != nullptr ? newest->seq : 0);
+  json.beginArray("notes");
+  const Note* note = nullptr;
+  for (size_t i = 0; i < limit && (note = noteFromNewest(offset + i)) != nullptr; ++i) {
+    json.value(note->text);
+  }
+  json.endArray();
 }
 
+// GET /notes?offset=0&limit=20, newest first. `newest_seq` lets a client
+// paging back through older notes notice that new ones shifted the offsets.
 void handleNotesList() {
-  JsonDocument doc;
-  JsonArray arr = doc["notes"].to<JsonArray>();
-
-  for (size_t i = 0; i < notesCount; ++i) {
-    arr.add(notes[i]);
+  size_t offset = 0;
+  size_t limit = 0;
+  if (!unsignedArg("offset", 0, offset) || !unsignedArg("limit", kNotesPageDefault, limit) || limit == 0) {
+    JsonDocument error;
+    error["error"] = "Expected offset >= 0 and limit > 0";
+    sendJson(400, error);
+    return;
   }
+  if (limit > kNotesPageMax) limit = kNotesPageMax;
 
-  sendJson(200, doc);
+  JsonResponse response(200);
+  writeNotesPage(response.json, offset, limit);
 }
 
-void handleRemindersAdd() {
-  int minutes = 0;
-  String messageArg;
-  if (server.hasArg("minutes") && server.hasArg("message")) {
-    minutes = server.arg("minutes").toInt();
-    messageArg = server.arg("message");
-  } else {
-    JsonDocument doc;
-    if (!parseJsonBody(doc) || !doc["minutes"].is<int>() || !doc["message"].is<const char*>()) {
-      JsonDocument error;
-      error["error"] = "Expected minutes/message via query/form args or JSON body";
-      sendJson(400, error);
-      return;
-    }
-    minutes = doc["minutes"].as<int>();
-    messageArg = doc["message"].as<String>();
+// A reminder's timing from exactly one of "minutes" (> 0), "at" (local
+// "HH:MM" or "YYYY-MM-DDTHH:MM") or "cron"; returns an error message or nullptr.
+static const char* parseReminderWhen(JsonObjectConst fields, Schedule& out) {
+  JsonVariantConst minutes = fields["minutes"];
+  JsonVariantConst at = fields["at"];
+  JsonVariantConst cron = fields["cron"];
+  if (!minutes.isNull() + !at.isNull() + !cron.isNull() != 1) return "Give exactly one of minutes, at or cron";
+  if (!minutes.isNull()) {
+    if (!minutes.is<int>() || minutes.as<int>() <= 0) return "minutes must be > 0";
+    out = relativeSchedule(static_cast<uint32_t>(minutes.as<int>()));
+    return nullptr;
   }
+  if (!cron.isNull()) {
+    return cron.is<const char*>() ? parseCronSchedule(cron.as<const char*>(), out) : "cron must be a string";
+  }
+  if (!at.is<const char*>()) return "at must be a string";
+  const char* error = parseLocalTimeSchedule(at.as<const char*>(), out);
+  if (error != nullptr) return error;
+  uint32_t utcNow = 0;
+  long utcOffset = 0;
+  if (out.kind == ScheduleKind::Date && getWallClock(utcNow, utcOffset) && nextFireUtc(out, 0, utcOffset) <= utcNow) {
+    return "at is in the past";
+  }
+  return nullptr;
+}
 
-  if (minutes <= 0) {
+void handleRemindersAdd() {
+  JsonDocument doc;
+  if (server.hasArg("message")) {
+    // Query or form args, copied into a document so both paths validate alike.
+    doc["message"] = server.arg("message");
+    if (server.hasArg("minutes")) doc["minutes"] = server.arg("minutes").toInt();
+    if (server.hasArg("at")) doc["at"] = server.arg("at");
+    if (server.hasArg("cron")) doc["cron"] = server.arg("cron");
+  } else if (!parseJsonBody(doc) || !doc["message"].is<const char*>()) {
     JsonDocument error;
-    error["error"] = "minutes must be > 0";
+    error["error"] = "Expected message and one of minutes/at/cron via query/form args or JSON body";
     sendJson(400, error);
     return;
   }
 
-  size_t slot = kMaxReminders;
-  for (size_t i = 0; i < kMaxReminders; ++i) {
-    if (!reminders[i].active) {
-      slot = i;
-      break;
-    }
+  Schedule when;
+  const char* problem = parseReminderWhen(doc.as<JsonObjectConst>(), when);
+  if (problem != nullptr) {
+    JsonDocument error;
+    error["error"] = problem;
+    sendJson(400, error);
+    return;
   }
 
-  if (slot == kMaxReminders) {
+  uint32_t id = addReminder(when, doc["message"].as<String>());
+  if (id == 0) {
     JsonDocument error;
     error["error"] = "Reminder storage full";
     sendJson(507, error);
     return;
   }
 
-  reminders[slot].active = true;
-  reminders[slot].dueMs = millis() + static_cast<uint32_t>(minutes) * 60000UL;
-  reminders[slot].message = messageArg;
+  JsonResponse response(200);
+  response.json.field("ok", true);
+  response.json.field("id", id);
+  response.json.key("reminder");
+  writeReminder(response.json, *reminderFind(id), monotonicMs());
+}
+
+void handleRemindersList() {
+  static const Reminder* sorted[kMaxReminders];
+  size_t count = remindersByDue(sorted, kMaxReminders);
+  uint64_t now = monotonicMs();
+
+  JsonResponse response(200);
+  response.json.field("count", count);
+  response.json.field("capacity", kMaxReminders);
+  response.json.beginArray("reminders");
+  for (size_t i = 0; i < count; ++i) {
+    writeReminder(response.json, *sorted[i], now);
+  }
+  response.json.endArray();
+}
+
+// The reminder id comes from ?id= or the JSON body's "id"; 0 if neither is valid.
+static uint32_t reminderIdArg(JsonDocument& doc) {
+  if (server.hasArg("id")) return static_cast<uint32_t>(strtoul(server.arg("id").c_str(), nullptr, 10));
+  return doc["id"].is<unsigned long>() ? doc["id"].as<unsigned long>() : 0;
+}
+
+static void sendReminderNotFound(uint32_t id) {
+  JsonDocument error;
+  error["error"] = "No reminder with that id";
+  error["id"] = id;
+  sendJson(404, error);
+}
+
+void handleRemindersCancel() {
+  JsonDocument doc;
+  parseJsonBody(doc);
+  uint32_t id = reminderIdArg(doc);
+  if (!cancelReminder(id)) {
+    sendReminderNotFound(id);
+    return;
+  }
+  sendOk();
+}
+
+// PATCH /reminders {"id":N, "message":"...", plus one of minutes/at/cron}:
+// the message and the timing may each be left out.
+void handleRemindersEdit() {
+  JsonDocument doc;
+  if (!parseJsonBody(doc)) {
+    JsonDocument error;
+    error["error"] = "Expected JSON body: {\"id\":1,\"minutes\":10,\"message\":\"...\"}";
+    sendJson(400, error);
+    return;
+  }
+  uint32_t id = reminderIdArg(doc);
+  bool hasWhen = !doc["minutes"].isNull() || !doc["at"].isNull() || !doc["cron"].isNull();
+  bool hasMessage = !doc["message"].isNull();
+  const char* problem = nullptr;
+  Schedule when;
+  if (!hasWhen && !hasMessage) {
+    problem = "Give a message and/or one of minutes, at or cron";
+  } else if (hasMessage && !doc["message"].is<const char*>()) {
+    problem = "message must be a string";
+  } else if (hasWhen) {
+    problem = parseReminderWhen(doc.as<JsonObjectConst>(), when);
+  }
+  if (problem != nullptr) {
+    JsonDocument error;
+    error["error"] = problem;
+    sendJson(400, error);
+    return;
+  }
+
+  const char* message = hasMessage ? doc["message"].as<const char*>() : nullptr;
+  if (!editReminder(id, hasWhen ? &when : nullptr, message)) {
+    sendReminderNotFound(id);
+    return;
+  }
 
-  JsonDocument result;
-  result["ok"] = true;
-  result["slot"] = slot;
-  sendJson(200, result);
+  const Reminder* reminder = reminderFind(id);
+  JsonResponse response(200);
+  response.json.field("ok", true);
+  response.json.key("reminder");
+  writeReminder(response.json, *reminder, monotonicMs());
 }
 
 void handleClear() {
-  notesCount = 0;
-  speechText = "Cleared";
-  for (size_t i = 0; i < kMaxReminders; ++i) {
-    reminders[i].active = false;
-  }
-
-  JsonDocument result;
-  result["ok"] = true;
-  sendJson(200, result);
-}
-
-void handleRoot() {
-  String msg = statusMessageFromCode(server.arg("msg"));
-  String html;
-  html.reserve(8500);
-
-  html += "<!doctype html><html><head><meta charset='utf-8'>";
-  html += "<meta name='viewport' content='width=device-width,initial-scale=1'>";
-  html += "<title>Companion 313</title>";
-  html += "<style>";
-  html += "body{font-family:Trebuchet MS,Segoe UI,sans-serif;background:#0c1424;color:#e9efff;margin:0;padding:16px}";
-  html += ".wrap{max-width:960px;margin:0 auto}.card{border:1px solid #2e466a;background:#12203a;border-radius:10px;padding:12px;margin-bottom:10px}";
-  html += ".row{display:flex;gap:8px;flex-wrap:wrap;align-items:center}.grid{display:grid;gap:10px;grid-template-columns:repeat(auto-fit,minmax(260px,1fr))}";
-  html += ".topgrid{display:grid;gap:10px;grid-template-columns:1fr 1fr 1fr;margin-bottom:10px}.stack{display:grid;gap:10px}";
-  html += "input,select,button{background:#0f1a2f;color:#e9efff;border:1px solid #3b5d90;border-radius:8px;padding:8px}";
-  html += "input,select{flex:1;min-width:110px}button{cursor:pointer}ul{margin:6px 0 0 18px}.muted{color:#9fb3d8}";
-  html += ".msg{padding:8px;border-radius:8px;background:#173158;border:1px solid #3b5d90;margin:8px 0}";
-  html += "code{display:block;white-space:pre-wrap;word-break:break-word;background:#0b1528;padding:6px;border-radius:6px}";
-  html += "@media (max-width:800px){.topgrid{grid-template-columns:1fr}}";
-  html += "a{color:#80d5ff}";
-  html += "</style></head><body><div class='wrap'>";
-  html += "<h1>Companion 313 Control Panel</h1>";
-
-  if (msg.length() > 0) {
-    html += "<div class='msg'>";
-    html += msg;
-    html += "</div>";
-  }
-
-  html += "<div class='topgrid'>";
-  html += "<div class='card'><h2>Status</h2>";
-  html += "<p><b>IP:</b> ";
-  html += currentIpAddress();
-  html += "<br><b>Speech:</b> ";
-  html += htmlEscape(speechText);
-  html += "<br><b>Notes:</b> ";
-  html += String(notesCount);
-  html += "<br><b>Info Temp:</b> ";
-  html += htmlEscape(infoTemperature);
-  html += "<br><b>Info Temp Unit:</b> ";
-  html += infoTempUnitLabel();
-  html += "<br><b>Info Lat/Lon:</b> ";
-  html += String(infoLatitude, 4);
-  html += ", ";
-  html += String(infoLongitude, 4);
-  html += "<br><b>Local Time:</b> ";
-  html += htmlEscape(getLocalTimeString());
-  if (infoTimezoneAbbr.length() > 0) {
-    html += " (";
-    html += htmlEscape(infoTimezoneAbbr);
-    html += ")";
-  }
-  if (!sntpCallbackFired) {
-    html += " <span class='muted'>[NTP not synced]</span>";
-  }
-  html += "</p><p><a href='/'>Refresh status</a> | <a href='/status'>Raw /status JSON</a></p></div>";
-
-  html += "<div class='stack'>";
-  html += "<div class='card'><h2>Info Settings</h2><form method='post' action='/ui/info'><div class='row'>";
-  html += "<input name='latitude' value='";
-  html += String(infoLatitude, 6);
-  html += "' placeholder='Latitude (e.g. 47.6062)'>";
-  html += "</div><div class='row'>";
-  html += "<input name='longitude' value='";
-  html += String(infoLongitude, 6);
-  html += "' placeholder='Longitude (e.g. -122.3321)'>";
-  html += "</div><div class='row'><select name='temperature_unit'>";
-  html += tempUnitOptionsHtml();
-  html += "</select><button type='submit'>Save Coords</button></div></form></div>";
-
-  html += "<div class='card'><h2>Speak</h2><form method='post' action='/ui/speak'><div class='row'>";
-  html += "<input name='text' maxlength='40' placeholder='Text for display'>";
-  html += "<button type='submit'>Send Speech</button></div></form></div>";
-  html += "</div>";
-
-  html += "<div class='stack'>";
-  html += "<div class='card'><h2>Display Mode</h2><form method='post' action='/ui/mode'><div class='row'><select name='mode'>";
-  html += modeOptionsHtml(currentDisplayMode);
-  html += "</select><button type='submit'>Set Mode</button></div></form></div>";
-
-  html += "<div class='card'><h2>Emotion</h2><form method='post' action='/ui/emotion'><div class='row'><select name='emotion'>";
-  html += emotionOptionsHtml(currentEmotion);
-  html += "</select><button type='submit'>Set Emotion</button></div></form></div>";
-  html += "</div>";
-  html += "</div>";
-
-  html += "<div class='grid'>";
-
-  html += "<div class='card'><h2>Add Note</h2><form method='post' action='/ui/notes'><div class='row'>";
-  html += "<input name='note' placeholder='New note'>";
-  html += "<button type='submit'>Add Note</button></div></form></div>";
-
-  html += "<div class='card'><h2>Add Reminder</h2><form method='post' action='/ui/reminders'><div class='row'>";
-  html += "<input name='minutes' type='number' min='1' value='10' style='max-width:90px'>";
-  html += "<input name='message' placeholder='Reminder message'>";
-  html += "<button type='submit'>Add Reminder</button></div></form></div>";
-
-  html += "<div class='card'><h2>Maintenance</h2><form method='post' action='/ui/clear'>";
-  html += "<button type='submit'>Clear Notes + Reminders</button></form></div>";
-
-  html += "</div>";
-
-  html += "<div class='card'><h2>Notes</h2><ul>";
-  if (notesCount == 0) {
-    html += "<li class='muted'>No notes</li>";
+  clearNotesAndReminders();
+  sendOk();
+}
+
+// One operation of a POST /batch request, parsed and validated up front.
+enum class BatchOpType : uint8_t { Emotion, Speak, Note, Reminder, Mode, Clear };
+
+struct BatchOp {
+  BatchOpType type;
+  Emotion emotion;
+  DisplayMode mode;
+  Schedule when;
+  const char* text;  // points into the request document
+};
+
+static constexpr size_t kMaxBatchOps = 16;
+static const char kBatchRemindersFull[] = "Reminder storage full";
+
+static const char* parseBatchOp(JsonObject item, BatchOp& op) {
+  const char* name = item["op"] | "";
+  if (strcmp(name, "emotion") == 0) {
+    op.type = BatchOpType::Emotion;
+    if (!item["emotion"].is<const char*>()) return "emotion op needs \"emotion\"";
+    if (!tryParseEmotion(item["emotion"].as<const char*>(), op.emotion)) return "Invalid emotion";
+  } else if (strcmp(name, "speak") == 0) {
+    op.type = BatchOpType::Speak;
+    if (!item["text"].is<const char*>()) return "speak op needs \"text\"";
+    op.text = item["text"].as<const char*>();
+  } else if (strcmp(name, "note") == 0) {
+    op.type = BatchOpType::Note;
+    if (!item["note"].is<const char*>()) return "note op needs \"note\"";
+    op.text = item["note"].as<const char*>();
+  } else if (strcmp(name, "reminder") == 0) {
+    op.type = BatchOpType::Reminder;
+    if (!item["message"].is<const char*>()) return "reminder op needs \"message\"";
+    const char* error = parseReminderWhen(item, op.when);
+    if (error != nullptr) return error;
+    op.text = item["message"].as<const char*>();
+  } else if (strcmp(name, "mode") == 0) {
+    op.type = BatchOpType::Mode;
+    if (!item["mode"].is<const char*>()) return "mode op needs \"mode\"";
+    if (!tryParseDisplayMode(item["mode"].as<const char*>(), op.mode)) return "Invalid mode. Use face or info.";
+  } else if (strcmp(name, "clear") == 0) {
+    op.type = BatchOpType::Clear;
   } else {
-    for (size_t i = 0; i < notesCount; ++i) {
-      html += "<li>";
-      html += htmlEscape(notes[i]);
-      html += "</li>";
+    return "Unknown op";
+  }
+  return nullptr;
+}
+
+// POST /batch {"ops":[{"op":"emotion","emotion":"happy"},{"op":"speak","text":"hi"},...]}
+// Every op is validated before any is applied, so a bad op changes nothing.
+// The display is redrawn once by loop() after the whole batch.
+void handleBatch() {
+  JsonDocument doc;
+  if (!parseJsonBody(doc) || !doc["ops"].is<JsonArray>()) {
+    JsonDocument error;
+    error["error"] = "Expected JSON body: {\"ops\":[{\"op\":\"emotion\",\"emotion\":\"happy\"}, ...]}";
+    sendJson(400, error);
+    return;
+  }
+  JsonArray items = doc["ops"].as<JsonArray>();
+  if (items.size() == 0 || items.size() > kMaxBatchOps) {
+    JsonDocument error;
+    error["error"] = "ops must hold 1 to 16 operations";
+    sendJson(400, error);
+    return;
+  }
+
+  BatchOp ops[kMaxBatchOps];
+  size_t opCount = 0;
+  size_t freeReminderSlots = kMaxReminders - reminderCount();
+
+  for (JsonObject item : items) {
+    BatchOp& op = ops[opCount];
+    const char* error = parseBatchOp(item, op);
+    // Track reminder capacity through the batch, including earlier clears.
+    if (error == nullptr && op.type == BatchOpType::Clear) {
+      freeReminderSlots = kMaxReminders;
+    } else if (error == nullptr && op.type == BatchOpType::Reminder) {
+      if (freeReminderSlots == 0) {
+        error = kBatchRemindersFull;
+      } else {
+        freeReminderSlots--;
+      }
+    }
+    if (error != nullptr) {
+      JsonDocument result;
+      result["ok"] = false;
+      result["index"] = opCount;
+      result["error"] = error;
+      // Same status codes as the single-op endpoints.
+      sendJson(error == kBatchRemindersFull ? 507 : 400, result);
+      return;
+    }
+    opCount++;
+  }
+
+  // Everything validated: apply in order, streaming each op's result.
+  JsonResponse response(200);
+  JsonWriter& json = response.json;
+  json.field("ok", true);
+  json.beginArray("results");
+  for (size_t i = 0; i < opCount; ++i) {
+    const BatchOp& op = ops[i];
+    json.beginObject();
+    json.field("ok", true);
+    switch (op.type) {
+      case BatchOpType::Emotion:
+        setEmotion(op.emotion);
+        json.field("emotion", emotionToString(currentEmotion));
+        break;
+      case BatchOpType::Speak:
+        setSpeech(op.text);
+        break;
+      case BatchOpType::Note:
+        json.field("count", addNote(op.text));
+        break;
+      case BatchOpType::Reminder:
+        json.field("id", addReminder(op.when, op.text));
+        break;
+      case BatchOpType::Mode:
+        setDisplayMode(op.mode);
+        json.field("mode", displayModeToString(currentDisplayMode));
+        break;
+      case BatchOpType::Clear:
+        clearNotesAndReminders();
+        break;
     }
+    json.endObject();
+  }
+  json.endArray();
+}
+
+#ifdef JSON_BENCH
+// Each benchmarked body through both writers: the full /status, /debug/stats,
+// the default /notes page and the POST /emotion reply as a typical mutation
+// response.
+template <typename Writer>
+static void benchStatus(Writer& json) {
+  writeStatusFields(json);
+}
+
+template <typename Writer>
+static void benchDiagnostics(Writer& json) {
+  writeDiagnostics(json);
+}
+
+template <typename Writer>
+static void benchNotesPage(Writer& json) {
+  writeNotesPage(json, 0, kNotesPageDefault);
+}
+
+template <typename Writer>
+static void benchEmotionResult(Writer& json) {
+  writeEmotionResult(json);
+}
+
+void handleJsonBench() {
+  static const JsonBenchCase kCases[] = {
+      {"status", benchStatus<JsonWriter>, benchStatus<JsonDocumentWriter>},
+      {"debug_stats", benchDiagnostics<JsonWriter>, benchDiagnostics<JsonDocumentWriter>},
+      {"notes", benchNotesPage<JsonWriter>, benchNotesPage<JsonDocumentWriter>},
+      {"emotion", benchEmotionResult<JsonWriter>, benchEmotionResult<JsonDocumentWriter>},
+  };
+  JsonDocument doc;
+  runJsonBench(doc, kCases, sizeof(kCases) / sizeof(kCases[0]));
+  sendJson(200, doc);
+}
+#endif
+
+void sendWebAsset(const WebAsset& asset) {
+  // Opening the panel counts as interaction; fetching its cached assets does not.
+  if (!asset.immutable) noteActivity();
+
+  server.sendHeader("ETag", asset.etag);
+  // The page is revalidated on every visit (a 304 while unchanged); CSS and JS
+  // are requested with ?v=<hash>, so any cached copy is current.
+  server.sendHeader("Cache-Control", asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+  if (server.header("If-None-Match") == asset.etag) {
+    server.send(304);
+    return;
   }
-  html += "</ul></div>";
-
-  html += "<div class='card'><h2>Reminders</h2><ul>";
-  uint32_t now = millis();
-  bool foundReminder = false;
-  for (size_t i = 0; i < kMaxReminders; ++i) {
-    if (!reminders[i].active) continue;
-    foundReminder = true;
-    uint32_t remaining = reminders[i].dueMs > now ? (reminders[i].dueMs - now) : 0;
-    html += "<li>";
-    html += htmlEscape(reminders[i].message);
-    html += " (";
-    html += String(remaining / 1000);
-    html += "s remaining)</li>";
-  }
-  if (!foundReminder) {
-    html += "<li class='muted'>No active reminders</li>";
-  }
-  html += "</ul></div>";
-
-  html += "<div class='card'><h2>Weather Debug</h2>";
-  html += "<p><b>Current Temperature:</b> ";
-  html += htmlEscape(infoTemperature);
-  html += "<br><b>Weather API Code:</b> ";
-  html += String(debugLastWeatherCode);
-  html += "<br><b>Weather Code:</b> ";
-  html += String(infoWeatherCode);
-  html += "</p>";
-  html += "<p><b>Weather API Payload:</b><br><code>";
-  html += htmlEscape(debugLastWeatherPayload);
-  html += "</code></p></div>";
-
-  html += "<div class='card'><h2>API Endpoints</h2>";
-  html += "<p class='muted'>GET /status, POST /emotion, POST /speak, GET/POST /notes, POST /reminders, POST /clear, POST /ui/mode, POST /ui/info</p>";
-  html += "</div>";
-
-  html += "</div></body></html>";
-  server.send(200, "text/html", html);
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, asset.contentType, reinterpret_cast<const char*>(asset.gzipData), asset.gzipLength);
 }
 
 void handleUiEmotion() {
@@ -517,12 +819,11 @@ void handleUiEmotion() {
     return;
   }
   Emotion parsed = Emotion::Neutral;
-  if (!tryParseEmotion(server.arg("emotion"), parsed)) {
+  if (!tryParseEmotion(server.arg("emotion").c_str(), parsed)) {
     sendUiRedirect("err_emotion");
     return;
   }
   setEmotion(parsed);
-  drawFace();
   sendUiRedirect("ok_emotion");
 }
 
@@ -532,15 +833,16 @@ void handleUiMode() {
     return;
   }
   DisplayMode parsed = DisplayMode::Face;
-  if (!tryParseDisplayMode(server.arg("mode"), parsed)) {
+  if (!tryParseDisplayMode(server.arg("mode").c_str(), parsed)) {
     sendUiRedirect("err_mode");
     return;
   }
-  currentDisplayMode = parsed;
+  setDisplayMode(parsed);
   sendUiRedirect("ok_mode");
 }
 
 void handleUiInfoSettings() {
+  noteActivity();
   if (!server.hasArg("latitude") || !server.hasArg("longitude")) {
     sendUiRedirect("err_info");
     return;
@@ -585,7 +887,9 @@ void handleUiInfoSettings() {
   infoUseFahrenheit = useFahrenheit;
   infoHasCoordinates = true;
   infoTempValid = false;
-  lastInfoTempFetchMs = 0;
+  bumpState(StateGroup::Info);
+  persistSettingsChanged();
+  requestInfoRefresh();
   serviceInfoData();
 
   sendUiRedirect("ok_info");
@@ -596,14 +900,12 @@ void handleUiSpeak() {
     sendUiRedirect("err_speak");
     return;
   }
-  speechText = server.arg("text");
-  if (speechText.length() == 0) {
+  String text = server.arg("text");
+  if (text.length() == 0) {
     sendUiRedirect("err_speak");
     return;
   }
-  if (speechText.length() > 40) {
-    speechText = speechText.substring(0, 40);
-  }
+  setSpeech(text);
   sendUiRedirect("ok_speak");
 }
 
@@ -617,69 +919,165 @@ void handleUiNotesAdd() {
     sendUiRedirect("err_note");
     return;
   }
-  if (notesCount >= kMaxNotes) {
-    for (size_t i = 1; i < kMaxNotes; ++i) {
-      notes[i - 1] = notes[i];
-    }
-    notesCount = kMaxNotes - 1;
-  }
-  notes[notesCount++] = note;
+  addNote(note.c_str());
   sendUiRedirect("ok_note");
 }
 
+// A non-empty "at" (HH:MM) takes precedence over "minutes".
 void handleUiRemindersAdd() {
-  if (!server.hasArg("minutes") || !server.hasArg("message")) {
+  if (!server.hasArg("message")) {
     sendUiRedirect("err_reminder");
     return;
   }
-  int minutes = server.arg("minutes").toInt();
   String message = server.arg("message");
-  if (minutes <= 0 || message.length() == 0) {
+  String at = server.hasArg("at") ? server.arg("at") : String();
+  at.trim();
+  Schedule when;
+  if (at.length() > 0) {
+    if (parseLocalTimeSchedule(at.c_str(), when) != nullptr) {
+      sendUiRedirect("err_reminder");
+      return;
+    }
+  } else {
+    int minutes = server.hasArg("minutes") ? server.arg("minutes").toInt() : 0;
+    if (minutes <= 0) {
+      sendUiRedirect("err_reminder");
+      return;
+    }
+    when = relativeSchedule(static_cast<uint32_t>(minutes));
+  }
+  if (message.length() == 0) {
     sendUiRedirect("err_reminder");
     return;
   }
-  size_t slot = kMaxReminders;
-  for (size_t i = 0; i < kMaxReminders; ++i) {
-    if (!reminders[i].active) {
-      slot = i;
-      break;
-    }
-  }
-  if (slot == kMaxReminders) {
+  if (addReminder(when, message) == 0) {
     sendUiRedirect("err_reminders_full");
     return;
   }
-  reminders[slot].active = true;
-  reminders[slot].dueMs = millis() + static_cast<uint32_t>(minutes) * 60000UL;
-  reminders[slot].message = message;
   sendUiRedirect("ok_reminder");
 }
 
 void handleUiClear() {
-  notesCount = 0;
-  speechText = "Cleared";
-  for (size_t i = 0; i < kMaxReminders; ++i) {
-    reminders[i].active = false;
-  }
+  clearNotesAndReminders();
   sendUiRedirect("ok_clear");
 }
 
+// ---------------------------------------------------------------------------
+// Routing
+// ---------------------------------------------------------------------------
+
+struct Route {
+  HTTPMethod method;
+  const char* path;
+  void (*handler)();
+  RouteClass routeClass;
+};
+
+static constexpr Route kRoutes[] = {
+    {HTTP_GET, "/status", handleStatus, RouteClass::Read},
+    {HTTP_GET, "/events", handleEvents, RouteClass::Read},
+    {HTTP_GET, "/debug/stats", handleDebugStats, RouteClass::Read},
+    {HTTP_POST, "/emotion", handleEmotion, RouteClass::Mutate},
+    {HTTP_POST, "/speak", handleSpeak, RouteClass::Mutate},
+    {HTTP_GET, "/notes", handleNotesList, RouteClass::Read},
+    {HTTP_POST, "/notes", handleNotesAdd, RouteClass::Mutate},
+    {HTTP_GET, "/reminders", handleRemindersList, RouteClass::Read},
+    {HTTP_POST, "/reminders", handleRemindersAdd, RouteClass::Mutate},
+    {HTTP_PATCH, "/reminders", handleRemindersEdit, RouteClass::Mutate},
+    {HTTP_DELETE, "/reminders", handleRemindersCancel, RouteClass::Mutate},
+    {HTTP_POST, "/clear", handleClear, RouteClass::Mutate},
+    {HTTP_POST, "/batch", handleBatch, RouteClass::Mutate},
+#ifdef JSON_BENCH
+    {HTTP_GET, "/debug/json-bench", handleJsonBench, RouteClass::Read},
+#endif
+    {HTTP_POST, "/ui/mode", handleUiMode, RouteClass::Ui},
+    {HTTP_POST, "/ui/info", handleUiInfoSettings, RouteClass::Ui},
+    {HTTP_POST, "/ui/emotion", handleUiEmotion, RouteClass::Ui},
+    {HTTP_POST, "/ui/speak", handleUiSpeak, RouteClass::Ui},
+    {HTTP_POST, "/ui/notes", handleUiNotesAdd, RouteClass::Ui},
+    {HTTP_POST, "/ui/reminders", handleUiRemindersAdd, RouteClass::Ui},
+    {HTTP_POST, "/ui/clear", handleUiClear, RouteClass::Ui},
+};
+
+static constexpr uint32_t routeHashStart(HTTPMethod method, uint32_t seed) {
+  return perfect_hash::start(seed, static_cast<uint8_t>(method));
+}
+
+struct RouteKeys {
+  static constexpr size_t kCount = sizeof(kRoutes) / sizeof(kRoutes[0]);
+  static constexpr size_t kSlots = 64;
+  static constexpr uint32_t hash(size_t i, uint32_t seed) {
+    return perfect_hash::hashString(kRoutes[i].path, routeHashStart(kRoutes[i].method, seed));
+  }
+};
+
+typedef PerfectHash<RouteKeys> RouteHash;
+
+static const Route* findRoute(HTTPMethod method, const char* path) {
+  uint32_t hash = perfect_hash::hashString(path, routeHashStart(method, RouteHash::kSeed));
+  size_t index = RouteHash::candidate(hash);
+  if (index >= RouteKeys::kCount) return nullptr;
+  const Route& route = kRoutes[index];
+  return route.method == method && strcmp(route.path, path) == 0 ? &route : nullptr;
+}
+
+static const WebAsset* findWebAsset(const char* path) {
+  for (size_t i = 0; i < sizeof(kWebAssets) / sizeof(kWebAssets[0]); ++i) {
+    if (strcmp(kWebAssets[i].path, path) == 0) return &kWebAssets[i];
+  }
+  return nullptr;
+}
+
+// Admission control ahead of every handler; on refusal the 429 is already sent.
+static bool admit(RouteClass routeClass) {
+  uint32_t retryAfterMs = 0;
+  uint32_t clientIp = static_cast<uint32_t>(server.client().remoteIP());
+  if (admitRequest(clientIp, routeClass, millis(), retryAfterMs)) return true;
+
+  char retryAfter[12];
+  snprintf(retryAfter, sizeof(retryAfter), "%lu", static_cast<unsigned long>((retryAfterMs + 999) / 1000));
+  server.sendHeader("Retry-After", retryAfter);
+  JsonResponse response(429);
+  response.json.field("error", "Too many requests");
+  response.json.field("route_class", routeClassToString(routeClass));
+  response.json.field("retry_after_ms", retryAfterMs);
+  return false;
+}
+
+// Registered as the server's only handler. WebServer otherwise walks one
+// handler per on() call and hands each a copy of the URI; here a request costs
+// one hash and one compare. Unmatched requests fall through to the stock 404.
+class RouteDispatcher : public RequestHandler {
+ public:
+  bool canHandle(HTTPMethod method, String uri) override {
+    route = findRoute(method, uri.c_str());
+    asset = (route == nullptr && method == HTTP_GET) ? findWebAsset(uri.c_str()) : nullptr;
+    return route != nullptr || asset != nullptr;
+  }
+
+  bool handle(WebServer&, HTTPMethod, String) override {
+    if (route != nullptr) {
+      if (admit(route->routeClass)) route->handler();
+    } else if (asset != nullptr) {
+      if (admit(RouteClass::Ui)) sendWebAsset(*asset);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  // Set by canHandle() for the handle() call that immediately follows it.
+  const Route* route = nullptr;
+  const WebAsset* asset = nullptr;
+};
+
+static RouteDispatcher routeDispatcher;
+
 void setupServer() {
-  server.on("/", HTTP_GET, handleRoot);
-  server.on("/status", HTTP_GET, handleStatus);
-  server.on("/emotion", HTTP_POST, handleEmotion);
-  server.on("/speak", HTTP_POST, handleSpeak);
-  server.on("/notes", HTTP_GET, handleNotesList);
-  server.on("/notes", HTTP_POST, handleNotesAdd);
-  server.on("/reminders", HTTP_POST, handleRemindersAdd);
-  server.on("/clear", HTTP_POST, handleClear);
-  server.on("/ui/mode", HTTP_POST, handleUiMode);
-  server.on("/ui/info", HTTP_POST, handleUiInfoSettings);
-  server.on("/ui/emotion", HTTP_POST, handleUiEmotion);
-  server.on("/ui/speak", HTTP_POST, handleUiSpeak);
-  server.on("/ui/notes", HTTP_POST, handleUiNotesAdd);
-  server.on("/ui/reminders", HTTP_POST, handleUiRemindersAdd);
-  server.on("/ui/clear", HTTP_POST, handleUiClear);
+  server.addHandler(&routeDispatcher);
+  static const char* kCollectedHeaders[] = {"If-None-Match"};
+  server.collectHeaders(kCollectedHeaders, 1);
   server.begin();
 
   Serial.println("HTTP API started on port 80");
@@ -6,5 +6,8 @@
 
 extern WebServer server;
 
+static constexpr size_t kIpAddressBytes = 16;
+void currentIpAddress(char* out, size_t size);
 String currentIpAddress();
+void sendJson(int statusCode, JsonDocument& doc);
 void setupServer();
@@ -0,0 +1,26 @@
+#pragma once
+// Just enough of the Arduino core for the renderer to build on a desktop host.
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+// Host clock, driven by the harness so animation-dependent code is deterministic.
+uint32_t millis();
+uint32_t micros();
+long random(long low, long high);
+
+#define constrain(value, low, high) ((value) < (low) ? (low) : ((value) > (high) ? (high) : (value)))
+
+class String {
+ public:
+  String(const char* text = "") : value(text != nullptr ? text : "") {}
+  const char* c_str() const { return value.c_str(); }
+  unsigned int length() const { return static_cast<unsigned int>(value.size()); }
+
+ private:
+  std::string value;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <Arduino.h>
+#include <u8g2.h>
+#include "render_profile.h"
+
+// Host stand-in for U8g2's Arduino class: the calls the renderer makes, passed
+// to U8g2's C core with the same SSD1306 128x64 full-frame setup as the
+// firmware and a bus that discards everything. Frames stay in RAM.
+//
+// Each drawing call is a RenderPrimitive for the benchmark; pixels are counted
+// in U8g2's low-level span writer, which every shape and glyph goes through.
+
+inline void profiledSpan(u8g2_t* u8g2, u8g2_uint_t x, u8g2_uint_t y, u8g2_uint_t len, uint8_t dir) {
+  RENDER_PROFILE_PIXELS(len);
+  u8g2_ll_hvline_vertical_top_lsb(u8g2, x, y, len, dir);
+}
+
+class U8G2_SSD1306_128X64_NONAME_F_HW_I2C {
+ public:
+  U8G2_SSD1306_128X64_NONAME_F_HW_I2C(const u8g2_cb_t* rotation, uint8_t reset) {
+    (void)reset;
+    u8g2_Setup_ssd1306_128x64_noname_f(&u8g2, rotation, u8x8_byte_empty, u8x8_dummy_cb);
+    u8g2.ll_hvline = profiledSpan;
+  }
+
+  bool begin() { return true; }
+  void clearBuffer() { u8g2_ClearBuffer(&u8g2); }
+  void sendBuffer() {}
+  uint8_t* getBufferPtr() { return u8g2_GetBufferPtr(&u8g2); }
+  u8g2_t* getU8g2() { return &u8g2; }
+
+  void setFont(const uint8_t* font) { u8g2_SetFont(&u8g2, font); }
+  void setDrawColor(uint8_t color) { u8g2_SetDrawColor(&u8g2, color); }
+  u8g2_uint_t getStrWidth(const char* text) { return u8g2_GetStrWidth(&u8g2, text); }
+
+  u8g2_uint_t drawStr(u8g2_uint_t x, u8g2_uint_t y, const char* text) {
+    RENDER_PROFILE_SCOPE(RenderPrimitive::Text);
+    return u8g2_DrawStr(&u8g2, x, y, text);
+  }
+  u8g2_uint_t drawGlyph(u8g2_uint_t x, u8g2_uint_t y, uint16_t encoding) {
+    RENDER_PROFILE_SCOPE(RenderPrimitive::Glyph);
+    return u8g2_DrawGlyph(&u8g2, x, y, encoding);
+  }
+  void drawPixel(u8g2_uint_t x, u8g2_uint_t y) {
+    RENDER_PROFILE_SCOPE(RenderPrimitive::Pixel);
+    u8g2_DrawPixel(&u8g2, x, y);
+  }
+  void drawLine(u8g2_uint_t x1, u8g2_uint_t y1, u8g2_uint_t x2, u8g2_uint_t y2) {
+    RENDER_PROFILE_SCOPE(RenderPrimitive::Line);
+    u8g2_DrawLine(&u8g2, x1, y1, x2, y2);
+  }
+  void drawCircle(u8g2_uint_t x0, u8g2_uint_t y0, u8g2_uint_t r, uint8_t opt = U8G2_DRAW_ALL) {
+    RENDER_PROFILE_SCOPE(RenderPrimitive::Circle);
+    u8g2_DrawCircle(&u8g2, x0, y0, r, opt);
+  }
+  void drawDisc(u8g2_uint_t x0, u8g2_uint_t y0, u8g2_uint_t r, uint8_t opt = U8G2_DRAW_ALL) {
+    RENDER_PROFILE_SCOPE(RenderPrimitive::Disc);
+    u8g2_DrawDisc(&u8g2, x0, y0, r, opt);
+  }
+  void drawTriangle(int16_t x0, int16_t y0, int16_t x1, int16_t y1, int16_t x2, int16_t y2) {
+    RENDER_PROFILE_SCOPE(RenderPrimitive::Triangle);
+    u8g2_DrawTriangle(&u8g2, x0, y0, x1, y1, x2, y2);
+  }
+
+ private:
+  u8g2_t u8g2;
+};
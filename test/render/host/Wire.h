@@ -0,0 +1,2 @@
+#pragma once
+// The host renderer has no I2C bus.
@@ -0,0 +1,4 @@
+#pragma once
+// Placeholder so config.h builds on the host; nothing here connects anywhere.
+#define WIFI_SSID ""
+#define WIFI_PASSWORD ""
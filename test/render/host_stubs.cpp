@@ -0,0 +1,54 @@
+// Stand-ins for the firmware modules display.cpp and face.cpp link against
+// (main, weather, time sync, power, the transfer pipeline), reduced to plain
+// state the harness sets so every frame is reproducible.
+#include "host_stubs.h"
+#include "types.h"
+#include "weather.h"
+#include "time_sync.h"
+#include "power.h"
+#include "display_pipeline.h"
+
+uint32_t hostMillis = 0;
+HostClock hostClock = {false, 12, 0, false};
+
+Emotion currentEmotion = Emotion::Neutral;
+DisplayMode currentDisplayMode = DisplayMode::Face;
+String speechText = "";
+
+String infoTemperature = "Loading...";
+int infoWeatherCode = -1;
+uint32_t infoDataRevision = 0;
+
+uint32_t millis() {
+  return hostMillis;
+}
+
+uint32_t micros() {
+  return hostMillis * 1000UL;
+}
+
+long random(long low, long high) {
+  return high > low ? low + rand() % (high - low) : low;
+}
+
+bool getLocalTimeParts(int& hour12, int& minute, bool& pm) {
+  if (!hostClock.valid) return false;
+  hour12 = hostClock.hour12;
+  minute = hostClock.minute;
+  pm = hostClock.pm;
+  return true;
+}
+
+void flushDisplay(uint8_t speechScrollSteps) {
+  (void)speechScrollSteps;
+}
+
+void serviceDisplayPipeline() {}
+
+bool powerDisplayOff() {
+  return false;
+}
+
+uint32_t powerMinFrameIntervalMs() {
+  return 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include <Arduino.h>
+
+// What the renderer reads from the rest of the firmware, set by the harness.
+extern uint32_t hostMillis;
+
+struct HostClock {
+  bool valid;
+  int hour12;
+  int minute;
+  bool pm;
+};
+
+extern HostClock hostClock;
@@ -0,0 +1,306 @@
+// Host render check and benchmark. Renders every distinct face frame (emotion
+// x blink x animation phase), every weather icon and a few Info screens
+// through the firmware's own drawing code, compares them with the golden
+// frames in golden/ and reports ns/frame per group plus calls, pixels touched
+// and ns per primitive.
+//
+//   render_host               check against the goldens; a missing one fails
+//   render_host --update      (re)record every golden from the current renderer
+//   render_host --repeats N   timing runs per frame, fastest kept (default 20)
+//
+// Goldens are binary PBM strips, one 128x64 frame under another, lit pixels
+// black. A mismatching group is written to <name>.actual.pbm in the working
+// directory for comparison.
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "display.h"
+#include "face.h"
+#include "raster.h"
+#include "render_profile.h"
+#include "enum_names.h"
+#include "weather.h"
+#include "host_stubs.h"
+
+#ifndef RENDER_GOLDEN_DIR
+#define RENDER_GOLDEN_DIR "golden"
+#endif
+
+static constexpr int kDisplayHeight = 64;
+static constexpr size_t kPbmRowBytes = kDisplayWidth / 8;
+static const int kWeatherCodes[] = {-1, 0, 1, 2, 3, 45, 48, 51, 61, 71, 80, 85, 95};
+
+struct FrameCase {
+  std::string label;
+  std::function<void()> render;
+};
+
+struct GroupResult {
+  size_t frames;
+  uint64_t totalNs;
+  uint64_t maxNs;
+  uint64_t pixels;
+  bool failed;
+};
+
+static int timingRepeats = 20;
+static bool updateGoldens = false;
+
+static uint64_t nowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+static uint64_t profiledPixels() {
+  uint64_t pixels = 0;
+  for (size_t i = 0; i < kRenderPrimitiveCount; ++i) {
+    pixels += renderPrimitiveStats[i].pixels;
+  }
+  return pixels;
+}
+
+// Page-major SSD1306 frames (bit 0 = top row of a page) to PBM rows and back.
+static void frameToPbm(const uint8_t* frame, uint8_t* out) {
+  memset(out, 0, kPbmRowBytes * kDisplayHeight);
+  for (int y = 0; y < kDisplayHeight; ++y) {
+    for (int x = 0; x < kDisplayWidth; ++x) {
+      if ((frame[(y >> 3) * kDisplayWidth + x] >> (y & 7)) & 1) {
+        out[y * kPbmRowBytes + (x >> 3)] |= static_cast<uint8_t>(0x80 >> (x & 7));
+      }
+    }
+  }
+}
+
+static bool writePbm(const std::string& path, const std::vector<uint8_t>& rows, size_t frames) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (file == nullptr) return false;
+  fprintf(file, "P4\n%d %d\n", kDisplayWidth, static_cast<int>(frames) * kDisplayHeight);
+  bool ok = fwrite(rows.data(), 1, rows.size(), file) == rows.size();
+  return fclose(file) == 0 && ok;
+}
+
+static int readPbmNumber(FILE* file) {
+  int c = fgetc(file);
+  while (c == '#' || c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+    if (c == '#') {
+      while (c != '\n' && c != EOF) c = fgetc(file);
+    }
+    c = fgetc(file);
+  }
+  int value = -1;
+  while (c >= '0' && c <= '9') {
+    value = (value < 0 ? 0 : value * 10) + (c - '0');
+    c = fgetc(file);
+  }
+  return value;  // the single whitespace after the height is consumed here
+}
+
+// False if the file is missing or not a strip of 128-wide frames.
+static bool readPbm(const std::string& path, std::vector<uint8_t>& rows) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) return false;
+  char magic[2];
+  bool ok = fread(magic, 1, 2, file) == 2 && magic[0] == 'P' && magic[1] == '4';
+  int width = ok ? readPbmNumber(file) : -1;
+  int height = ok ? readPbmNumber(file) : -1;
+  ok = ok && width == kDisplayWidth && height > 0 && height % kDisplayHeight == 0;
+  if (ok) {
+    rows.resize(static_cast<size_t>(height) * kPbmRowBytes);
+    ok = fread(rows.data(), 1, rows.size(), file) == rows.size();
+  }
+  fclose(file);
+  return ok;
+}
+
+static size_t differingPixels(const uint8_t* a, const uint8_t* b) {
+  size_t count = 0;
+  for (size_t i = 0; i < kPbmRowBytes * kDisplayHeight; ++i) {
+    count += static_cast<size_t>(__builtin_popcount(a[i] ^ b[i]));
+  }
+  return count;
+}
+
+static GroupResult runGroup(const std::string& name, const std::vector<FrameCase>& cases) {
+  GroupResult result = {};
+  const size_t frameRowBytes = kPbmRowBytes * kDisplayHeight;
+  std::vector<uint8_t> actual(cases.size() * frameRowBytes);
+
+  for (size_t i = 0; i < cases.size(); ++i) {
+    // One profiled pass for the pixel counts and the frame itself...
+    uint64_t pixelsBefore = profiledPixels();
+    renderProfileEnabled = true;
+    display.clearBuffer();
+    cases[i].render();
+    renderProfileEnabled = false;
+    result.pixels += profiledPixels() - pixelsBefore;
+    frameToPbm(display.getBufferPtr(), &actual[i * frameRowBytes]);
+
+    // ...then unprofiled runs for the frame time.
+    uint64_t bestNs = UINT64_MAX;
+    for (int run = 0; run < timingRepeats; ++run) {
+      uint64_t started = nowNs();
+      display.clearBuffer();
+      cases[i].render();
+      uint64_t elapsed = nowNs() - started;
+      if (elapsed < bestNs) bestNs = elapsed;
+    }
+    result.frames++;
+    result.totalNs += bestNs;
+    if (bestNs > result.maxNs) result.maxNs = bestNs;
+  }
+
+  const std::string goldenPath = std::string(RENDER_GOLDEN_DIR) + "/" + name + ".pbm";
+  std::vector<uint8_t> golden;
+  if (updateGoldens) {
+    if (!writePbm(goldenPath, actual, cases.size())) {
+      fprintf(stderr, "%s: cannot write %s\n", name.c_str(), goldenPath.c_str());
+      result.failed = true;
+    }
+    return result;
+  }
+
+  if (!readPbm(goldenPath, golden)) {
+    fprintf(stderr, "%s: no readable golden at %s (record it with --update)\n", name.c_str(), goldenPath.c_str());
+    result.failed = true;
+  } else if (golden.size() != actual.size()) {
+    fprintf(stderr, "%s: golden has %zu frames, renderer produced %zu\n", name.c_str(),
+            golden.size() / frameRowBytes, cases.size());
+    result.failed = true;
+  } else {
+    for (size_t i = 0; i < cases.size(); ++i) {
+      size_t diff = differingPixels(&golden[i * frameRowBytes], &actual[i * frameRowBytes]);
+      if (diff == 0) continue;
+      fprintf(stderr, "%s: frame %zu (%s) differs in %zu pixels\n", name.c_str(), i, cases[i].label.c_str(),
+              diff);
+      result.failed = true;
+    }
+  }
+  if (result.failed) writePbm(name + ".actual.pbm", actual, cases.size());
+  return result;
+}
+
+static std::vector<FrameCase> faceCases(Emotion emotion) {
+  std::vector<FrameCase> cases;
+  for (int closed = 0; closed <= 1; ++closed) {
+    for (int glance = -1; glance <= 1; ++glance) {
+      for (int pulse2 = 0; pulse2 <= 1; ++pulse2) {
+        for (int pulse3 = -1; pulse3 <= 1; ++pulse3) {
+          for (int bobY = 0; bobY <= 1; ++bobY) {
+            FaceFrameKey key;
+            key.emotion = emotion;
+            key.closed = closed != 0;
+            key.glance = static_cast<int8_t>(glance);
+            key.pulse2 = static_cast<int8_t>(pulse2);
+            key.pulse3 = static_cast<int8_t>(pulse3);
+            key.bobY = static_cast<int8_t>(bobY);
+            key.gazeX = 0;
+            key.gazeY = 0;
+            // Only distinct frames count; the rest are cache aliases of these.
+            if (!faceKeysEqual(normalizeFaceKey(key), key)) continue;
+            char label[64];
+            snprintf(label, sizeof(label), "%s glance=%d pulse2=%d pulse3=%d bob=%d", closed ? "closed" : "open",
+                     glance, pulse2, pulse3, bobY);
+            cases.push_back({label, [key]() { renderFaceFeatures(key); }});
+          }
+        }
+      }
+    }
+  }
+  return cases;
+}
+
+static std::vector<FrameCase> weatherCases() {
+  std::vector<FrameCase> cases;
+  for (size_t i = 0; i < sizeof(kWeatherCodes) / sizeof(kWeatherCodes[0]); ++i) {
+    const int code = kWeatherCodes[i];
+    cases.push_back({"code " + std::to_string(code), [code]() { drawWeatherIcon(code, 56, 24); }});
+  }
+  return cases;
+}
+
+static std::vector<FrameCase> infoCases() {
+  struct InfoScene {
+    const char* label;
+    HostClock clock;
+    const char* temperature;
+    int weatherCode;
+  };
+  static const InfoScene kScenes[] = {
+      {"before NTP", {false, 12, 0, false}, "Loading...", -1},
+      {"morning", {true, 9, 41, false}, "72.4 F", 0},
+      {"evening", {true, 11, 5, true}, "-3.0 C", 61},
+      {"storm", {true, 12, 59, true}, "18.6 C", 95},
+  };
+  std::vector<FrameCase> cases;
+  for (size_t i = 0; i < sizeof(kScenes) / sizeof(kScenes[0]); ++i) {
+    const InfoScene scene = kScenes[i];
+    cases.push_back({scene.label, [scene]() {
+                       hostClock = scene.clock;
+                       infoTemperature = scene.temperature;
+                       infoWeatherCode = scene.weatherCode;
+                       renderInfoFrame();
+                     }});
+  }
+  return cases;
+}
+
+static void printGroup(const std::string& name, const GroupResult& result) {
+  printf("%-16s %5zu %12.0f %12llu %10.0f %s\n", name.c_str(), result.frames,
+         result.frames > 0 ? static_cast<double>(result.totalNs) / result.frames : 0.0,
+         static_cast<unsigned long long>(result.maxNs),
+         result.frames > 0 ? static_cast<double>(result.pixels) / result.frames : 0.0, result.failed ? "FAIL" : "ok");
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--update") {
+      updateGoldens = true;
+    } else if (arg == "--repeats" && i + 1 < argc) {
+      timingRepeats = atoi(argv[++i]);
+      if (timingRepeats < 1) timingRepeats = 1;
+    } else {
+      fprintf(stderr, "usage: %s [--update] [--repeats N]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  initRaster();
+  display.begin();
+  initInfoClockAtlas();
+  resetRenderProfile();
+
+  printf("%-16s %5s %12s %12s %10s\n", "group", "frames", "avg ns", "max ns", "px/frame");
+  bool failed = false;
+  for (size_t e = 0; e < kEmotionCount; ++e) {
+    const Emotion emotion = static_cast<Emotion>(e);
+    const std::string name = std::string("face_") + emotionToString(emotion);
+    GroupResult result = runGroup(name, faceCases(emotion));
+    printGroup(name, result);
+    failed = failed || result.failed;
+  }
+  const struct {
+    const char* name;
+    std::vector<FrameCase> cases;
+  } kOtherGroups[] = {{"weather", weatherCases()}, {"info", infoCases()}};
+  for (size_t i = 0; i < sizeof(kOtherGroups) / sizeof(kOtherGroups[0]); ++i) {
+    GroupResult result = runGroup(kOtherGroups[i].name, kOtherGroups[i].cases);
+    printGroup(kOtherGroups[i].name, result);
+    failed = failed || result.failed;
+  }
+
+  // Per-call times include two clock reads; compare them with each other, not with the frame times.
+  printf("\n%-10s %8s %10s %10s %10s\n", "primitive", "calls", "pixels", "px/call", "ns/call");
+  for (size_t i = 0; i < kRenderPrimitiveCount; ++i) {
+    const RenderPrimitiveStats& stats = renderPrimitiveStats[i];
+    if (stats.calls == 0) continue;
+    printf("%-10s %8llu %10llu %10.1f %10.1f\n", renderPrimitiveName(static_cast<RenderPrimitive>(i)),
+           static_cast<unsigned long long>(stats.calls), static_cast<unsigned long long>(stats.pixels),
+           static_cast<double>(stats.pixels) / stats.calls, static_cast<double>(stats.ns) / stats.calls);
+  }
+
+  if (updateGoldens) printf("\ngoldens written to %s\n", RENDER_GOLDEN_DIR);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,50 @@
+#include <time.h>
+#include "render_profile.h"
+
+bool renderProfileEnabled = false;
+RenderPrimitiveStats renderPrimitiveStats[kRenderPrimitiveCount];
+
+static int scopeDepth = 0;
+static RenderPrimitive activePrimitive = RenderPrimitive::Pixel;
+
+static const char* const kPrimitiveNames[kRenderPrimitiveCount] = {
+    "pixel", "hline", "box", "line", "disc", "circle", "rbox", "triangle", "text", "glyph",
+};
+
+static uint64_t nowNs() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+}
+
+const char* renderPrimitiveName(RenderPrimitive primitive) {
+  size_t index = static_cast<size_t>(primitive);
+  return index < kRenderPrimitiveCount ? kPrimitiveNames[index] : "?";
+}
+
+void resetRenderProfile() {
+  for (size_t i = 0; i < kRenderPrimitiveCount; ++i) {
+    renderPrimitiveStats[i] = RenderPrimitiveStats();
+  }
+}
+
+RenderProfileScope::RenderProfileScope(RenderPrimitive primitive)
+    : outermost(renderProfileEnabled && scopeDepth++ == 0), primitive(primitive), startedNs(0) {
+  if (!outermost) return;
+  activePrimitive = primitive;
+  startedNs = nowNs();
+}
+
+RenderProfileScope::~RenderProfileScope() {
+  if (!renderProfileEnabled) return;
+  scopeDepth--;
+  if (!outermost) return;
+  RenderPrimitiveStats& stats = renderPrimitiveStats[static_cast<size_t>(primitive)];
+  stats.calls++;
+  stats.ns += nowNs() - startedNs;
+}
+
+void renderProfilePixels(uint32_t count) {
+  if (!renderProfileEnabled || scopeDepth == 0) return;
+  renderPrimitiveStats[static_cast<size_t>(activePrimitive)].pixels += count;
+}
@@ -0,0 +1,233 @@
+// Host tests for the UDP control channel: the packet decoder, the sequence
+// filter, and one loopback round trip through beginUdpControl() and
+// serviceUdpControl() on 127.0.0.1.
+//
+//   udp_host    runs every case; exits 1 if any check fails
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "udp_control.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                 \
+  do {                                                                              \
+    if (!(cond)) {                                                                  \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);      \
+      failures++;                                                                   \
+    }                                                                               \
+  } while (0)
+
+// Builds a datagram the way app.py does; sections follow the flags.
+class PacketBuilder {
+ public:
+  PacketBuilder(uint8_t flags, uint16_t session, uint32_t sequence) {
+    bytes = {kControlMagic0, kControlMagic1, kControlVersion, flags};
+    u16(session);
+    u32(sequence);
+  }
+
+  PacketBuilder& u8(uint8_t value) {
+    bytes.push_back(value);
+    return *this;
+  }
+  PacketBuilder& u16(uint16_t value) {
+    u8(static_cast<uint8_t>(value));
+    return u8(static_cast<uint8_t>(value >> 8));
+  }
+  PacketBuilder& u32(uint32_t value) {
+    u16(static_cast<uint16_t>(value));
+    return u16(static_cast<uint16_t>(value >> 16));
+  }
+  PacketBuilder& speech(const std::string& text) {
+    u8(static_cast<uint8_t>(text.size()));
+    bytes.insert(bytes.end(), text.begin(), text.end());
+    return *this;
+  }
+
+  bool decode(ControlPacket& out) const { return decodeControlPacket(bytes.data(), bytes.size(), out); }
+  bool decodes() const {
+    ControlPacket packet;
+    return decode(packet);
+  }
+
+  std::vector<uint8_t> bytes;
+};
+
+static void testDecodeValid() {
+  ControlPacket packet;
+  PacketBuilder full(kControlEmotion | kControlGaze | kControlSpeech, 0x1234, 0xA1B2C3D4);
+  full.u8(3).u8(static_cast<uint8_t>(-4)).u8(2).speech("hello");
+  CHECK(full.decode(packet));
+  CHECK(packet.flags == (kControlEmotion | kControlGaze | kControlSpeech));
+  CHECK(packet.session == 0x1234);
+  CHECK(packet.sequence == 0xA1B2C3D4);
+  CHECK(packet.emotion == 3);
+  CHECK(packet.gazeX == -4);
+  CHECK(packet.gazeY == 2);
+  CHECK(packet.speechLength == 5);
+  CHECK(strcmp(packet.speech, "hello") == 0);
+
+  // Header only: a keepalive that changes nothing.
+  CHECK(PacketBuilder(0, 1, 1).decode(packet));
+  CHECK(packet.flags == 0 && packet.speech[0] == '\0');
+  CHECK(PacketBuilder(kControlGazeRelease, 1, 1).decodes());
+  // Empty speech clears the line.
+  CHECK(PacketBuilder(kControlSpeech, 1, 1).speech("").decode(packet));
+  CHECK(packet.speechLength == 0 && packet.speech[0] == '\0');
+
+  // Longest legal datagram.
+  PacketBuilder longest(kControlEmotion | kControlGaze | kControlSpeech, 1, 1);
+  longest.u8(0).u8(0).u8(0).speech(std::string(kControlMaxSpeech, 'x'));
+  CHECK(longest.bytes.size() == kControlMaxPacket);
+  CHECK(longest.decode(packet));
+  CHECK(packet.speechLength == kControlMaxSpeech && strlen(packet.speech) == kControlMaxSpeech);
+}
+
+static void testDecodeTruncated() {
+  PacketBuilder header(0, 1, 1);
+  for (size_t length = 0; length < kControlHeaderBytes; ++length) {
+    ControlPacket packet;
+    CHECK(!decodeControlPacket(header.bytes.data(), length, packet));
+  }
+  CHECK(!PacketBuilder(kControlEmotion, 1, 1).decodes());
+  CHECK(!PacketBuilder(kControlGaze, 1, 1).u8(1).decodes());
+  CHECK(!PacketBuilder(kControlSpeech, 1, 1).decodes());  // no length byte
+  CHECK(!PacketBuilder(kControlSpeech, 1, 1).u8(5).u8('a').u8('b').decodes());
+  // A later section missing after an earlier complete one.
+  CHECK(!PacketBuilder(kControlEmotion | kControlSpeech, 1, 1).u8(2).decodes());
+  // Every cut of a full packet fails except the full length.
+  PacketBuilder full(kControlEmotion | kControlGaze | kControlSpeech, 1, 1);
+  full.u8(1).u8(2).u8(3).speech("abc");
+  for (size_t length = 0; length < full.bytes.size(); ++length) {
+    ControlPacket packet;
+    CHECK(!decodeControlPacket(full.bytes.data(), length, packet));
+  }
+}
+
+static void testDecodeRejects() {
+  // Unknown flag bits, even alongside known ones.
+  CHECK(!PacketBuilder(0x10, 1, 1).decodes());
+  CHECK(!PacketBuilder(0x80 | kControlEmotion, 1, 1).u8(1).decodes());
+  // Wrong magic or version.
+  PacketBuilder magic(0, 1, 1);
+  magic.bytes[1] = 'X';
+  CHECK(!magic.decodes());
+  PacketBuilder version(0, 1, 1);
+  version.bytes[2] = kControlVersion + 1;
+  CHECK(!version.decodes());
+  // Trailing bytes after the last section.
+  CHECK(!PacketBuilder(0, 1, 1).u8(0).decodes());
+  CHECK(!PacketBuilder(kControlEmotion, 1, 1).u8(1).u8(0).decodes());
+  // Embedded NUL in the speech bytes.
+  CHECK(!PacketBuilder(kControlSpeech, 1, 1).speech(std::string("ab\0cd", 5)).decodes());
+  CHECK(!PacketBuilder(kControlSpeech, 1, 1).speech(std::string("\0", 1)).decodes());
+  // Speech longer than kControlMaxSpeech, and a datagram past kControlMaxPacket.
+  CHECK(!PacketBuilder(kControlSpeech, 1, 1).speech(std::string(kControlMaxSpeech + 1, 'x')).decodes());
+  PacketBuilder oversized(kControlEmotion | kControlGaze | kControlSpeech, 1, 1);
+  oversized.u8(0).u8(0).u8(0).speech(std::string(kControlMaxSpeech, 'x'));
+  oversized.u8(0);
+  CHECK(!oversized.decodes());
+}
+
+static bool accept(uint16_t session, uint32_t sequence) {
+  ControlPacket packet;
+  CHECK(PacketBuilder(0, session, sequence).decode(packet));
+  return acceptControlSequence(packet);
+}
+
+static void testSequence() {
+  // In order, duplicates and reordering within one session.
+  CHECK(accept(100, 5));
+  CHECK(!accept(100, 5));
+  CHECK(!accept(100, 4));
+  CHECK(accept(100, 6));
+  CHECK(accept(100, 1000));
+  CHECK(!accept(100, 999));
+
+  // Serial-number comparison across the 32-bit wrap.
+  CHECK(accept(200, 0xFFFFFFFEu));
+  CHECK(accept(200, 0xFFFFFFFFu));
+  CHECK(accept(200, 0));
+  CHECK(!accept(200, 0xFFFFFFFFu));
+  CHECK(accept(200, 1));
+  // More than half the sequence space ahead reads as old.
+  CHECK(!accept(200, 0x80000001u + 1));
+
+  // A different session takes over at once, whatever its sequence...
+  CHECK(accept(300, 7));
+  CHECK(accept(301, 1));
+  // ...and the previous session's packets now count as a takeover too.
+  CHECK(!accept(301, 1));
+  CHECK(accept(300, 8));
+}
+
+static void testLoopback() {
+  uint16_t port = 0;
+  for (uint16_t candidate = 39130; candidate < 39160 && port == 0; ++candidate) {
+    if (beginUdpControl(candidate)) port = candidate;
+  }
+  CHECK(port != 0);
+  if (port == 0) return;
+
+  int sender = socket(AF_INET, SOCK_DGRAM, 0);
+  CHECK(sender >= 0);
+  sockaddr_in to;
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_port = htons(port);
+  to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  auto send = [&](const PacketBuilder& packet) {
+    ssize_t sent = sendto(sender, packet.bytes.data(), packet.bytes.size(), 0, reinterpret_cast<sockaddr*>(&to),
+                          sizeof(to));
+    CHECK(sent == static_cast<ssize_t>(packet.bytes.size()));
+  };
+
+  PacketBuilder first(kControlEmotion | kControlSpeech, 400, 10);
+  first.u8(2).speech("over udp");
+  PacketBuilder newer(kControlGaze, 400, 11);
+  newer.u8(static_cast<uint8_t>(-3)).u8(1);
+  send(first);
+  send(PacketBuilder(0x40, 400, 12));  // unknown flag
+  send(first);                         // duplicate
+  send(newer);
+
+  static std::vector<ControlPacket> applied;
+  applied.clear();
+  const uint32_t receivedBefore = udpPacketsReceived;
+  // Loopback delivery is immediate, but allow the stack a moment.
+  for (int attempt = 0; attempt < 50 && udpPacketsReceived - receivedBefore < 4; ++attempt) {
+    serviceUdpControl([](const ControlPacket& packet) { applied.push_back(packet); });
+    if (udpPacketsReceived - receivedBefore < 4) usleep(2000);
+  }
+  close(sender);
+
+  CHECK(udpPacketsReceived - receivedBefore == 4);
+  CHECK(udpPacketsMalformed == 1);
+  CHECK(udpPacketsStale == 1);
+  CHECK(udpPacketsApplied == 2);
+  CHECK(applied.size() == 2);
+  if (applied.size() == 2) {
+    CHECK(applied[0].sequence == 10 && applied[0].emotion == 2 && strcmp(applied[0].speech, "over udp") == 0);
+    CHECK(applied[1].sequence == 11 && applied[1].gazeX == -3 && applied[1].gazeY == 1);
+  }
+}
+
+int main() {
+  testDecodeValid();
+  testDecodeTruncated();
+  testDecodeRejects();
+  testSequence();
+  testLoopback();
+  if (failures > 0) {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("udp control: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,118 @@
+// Fills the static panel from /status, /reminders (for the countdowns) and
+// /debug/stats. Forms still post to /ui/* and come back to /?msg=<code>.
+(function () {
+  var MESSAGES = {
+    ok_emotion: 'Emotion updated.',
+    ok_speak: 'Speech updated.',
+    ok_note: 'Note added.',
+    ok_reminder: 'Reminder added.',
+    ok_clear: 'Cleared notes and reminders.',
+    ok_mode: 'Display mode updated.',
+    ok_info: 'Info settings updated.',
+    err_emotion: 'Invalid emotion.',
+    err_speak: 'Speech text missing.',
+    err_note: 'Note text missing.',
+    err_reminder: 'Reminder needs minutes > 0 and message.',
+    err_reminders_full: 'Reminder storage full.',
+    err_mode: 'Invalid mode. Use face or info.',
+    err_info: 'Latitude/longitude required and must be valid.'
+  };
+
+  function $(id) { return document.getElementById(id); }
+  function text(id, value) { $(id).textContent = value == null ? '' : String(value); }
+
+  function fillList(id, items, empty) {
+    var list = $(id);
+    list.textContent = '';
+    if (items.length === 0) items = [{ text: empty, muted: true }];
+    items.forEach(function (item) {
+      var li = document.createElement('li');
+      li.textContent = item.text;
+      if (item.muted) li.className = 'muted';
+      if (item.action) {
+        var button = document.createElement('button');
+        button.type = 'button';
+        button.className = 'inline';
+        button.textContent = item.action.label;
+        button.addEventListener('click', item.action.run);
+        li.appendChild(document.createTextNode(' '));
+        li.appendChild(button);
+      }
+      list.appendChild(li);
+    });
+  }
+
+  function render(s) {
+    var notes = s.notes || [];
+    text('ip', s.ip);
+    text('speech', s.speech);
+    text('notes-count', s.notes_total !== undefined ? s.notes_total : notes.length);
+    text('temp', s.info_temperature);
+    text('temp-unit', s.info_temperature_unit);
+    text('latlon', Number(s.info_latitude).toFixed(4) + ', ' + Number(s.info_longitude).toFixed(4));
+    text('local-time', s.info_local_time);
+    text('tz', s.info_timezone_abbr ? '(' + s.info_timezone_abbr + ')' : '');
+    $('ntp').hidden = !!s.sntp_callback_fired;
+
+    $('latitude').value = Number(s.info_latitude).toFixed(6);
+    $('longitude').value = Number(s.info_longitude).toFixed(6);
+    $('temperature-unit').value = s.info_temperature_unit === 'C' ? 'c' : 'f';
+    if (s.speech_max_chars) $('speech-input').maxLength = s.speech_max_chars;
+    $('mode').value = s.mode;
+    $('emotion').value = s.emotion;
+
+    var noteItems = notes.map(function (n) { return { text: n }; });
+    if (s.notes_total > notes.length) {
+      noteItems.push({ text: '+' + (s.notes_total - notes.length) + ' older (GET /notes?offset=' + notes.length + ')', muted: true });
+    }
+    fillList('notes', noteItems, 'No notes');
+
+    text('debug-temp', s.info_temperature);
+    text('debug-weather-code', s.info_weather_code);
+  }
+
+  function renderReminders(list) {
+    var reminderItems = (list.reminders || []).map(function (r) {
+      var when = r.ms_remaining === null ? 'waiting for clock' : Math.floor(r.ms_remaining / 1000) + 's remaining';
+      if (r.schedule) when = r.schedule + ', ' + when;
+      return {
+        text: r.message + ' (' + when + ')',
+        action: { label: 'Cancel', run: function () { cancelReminder(r.id); } }
+      };
+    });
+    fillList('reminders', reminderItems, 'No active reminders');
+  }
+
+  function renderStats(d) {
+    text('debug-api-code', d.debug_weather_api_code);
+    text('debug-payload', d.debug_weather_api_payload);
+  }
+
+  function load(path, then) {
+    return fetch(path, { cache: 'no-store' })
+      .then(function (r) { return r.json(); })
+      .then(then);
+  }
+
+  function refresh() {
+    load('/status', render).catch(function () { text('ip', 'unreachable'); });
+    load('/reminders', renderReminders).catch(function () {});
+    load('/debug/stats', renderStats).catch(function () {});
+  }
+
+  function cancelReminder(id) {
+    fetch('/reminders?id=' + encodeURIComponent(id), { method: 'DELETE' })
+      .then(refresh, refresh);
+  }
+
+  var code = new URLSearchParams(location.search).get('msg');
+  if (code && MESSAGES[code]) {
+    text('msg', MESSAGES[code]);
+    $('msg').hidden = false;
+  }
+  $('refresh').addEventListener('click', function (e) {
+    e.preventDefault();
+    refresh();
+  });
+  refresh();
+})();